@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2016 Nicholas Fraser
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark.h"
+#include "msgpack11.hpp"
+
+#include <stdexcept>
+
+// Decodes and re-encodes arrays of uint32, uint64 and float64, which is
+// dominated by multi-byte loads and stores rather than by the tree.
+
+static std::string encoded;
+
+bool run_test(uint32_t* hash_out) {
+    try {
+        std::string err;
+        msgpack11::MsgPack pack = msgpack11::MsgPack::parse(encoded, err);
+        if (!err.empty())
+            return false;
+        uint32_t hash = *hash_out;
+        for (const msgpack11::MsgPack& column : pack.as<msgpack11::MsgPack::array>()) {
+            for (const msgpack11::MsgPack& item : column.as<msgpack11::MsgPack::array>()) {
+                if (item.is_float64())
+                    hash = hash_double(hash, item.as<double>());
+                else
+                    hash = hash_u64(hash, item.as<uint64_t>());
+            }
+        }
+        std::string buffer = pack.dump();
+        *hash_out = hash_str(hash, buffer.c_str(), buffer.size());
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+bool setup_test(size_t object_size) {
+    size_t const count = size_t(1) << (2 * object_size + 4);
+    msgpack11::MsgPack::array u32, u64, f64;
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < count; ++i) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        // Keep every value out of the shorter encodings.
+        u32.push_back(static_cast<uint32_t>((state >> 32) | 0x10000u));
+        u64.push_back(static_cast<uint64_t>(state | (1ULL << 63)));
+        f64.push_back(static_cast<double>(state >> 11) / 3.0);
+    }
+    encoded = msgpack11::MsgPack(msgpack11::MsgPack::array{ u32, u64, f64 }).dump();
+    return true;
+}
+
+void teardown_test(void) {
+    encoded.clear();
+}
+
+bool is_benchmark(void) {
+    return true;
+}
+
+const char* test_version(void) {
+    return "0.0.9";
+}
+
+const char* test_language(void) {
+    return BENCHMARK_LANGUAGE_CXX;
+}
+
+const char* test_format(void) {
+    return "MessagePack";
+}
+
+const char* test_filename(void) {
+    return __FILE__;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2016 Nicholas Fraser
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark.h"
+#include "msgpack11.hpp"
+
+#include <string>
+#include <stdexcept>
+
+static object_t* root_object;
+
+static void pack_object(msgpack11::Packer& packer, object_t* object) {
+    switch (object->type) {
+        case type_bool:
+            packer.pack_bool(object->b);
+            return;
+        case type_nil:
+            packer.pack_nil();
+            return;
+        case type_int:
+            packer.pack_int(object->i);
+            return;
+        case type_uint:
+            packer.pack_uint(object->u);
+            return;
+        case type_double:
+            packer.pack_double(object->d);
+            return;
+        case type_str:
+            packer.pack_str(std::string_view(object->str, object->l));
+            return;
+        case type_array:
+            packer.begin_array(object->l);
+            for (size_t i = 0; i < object->l; ++i)
+                pack_object(packer, object->children + i);
+            return;
+        case type_map:
+            packer.begin_map(object->l);
+            for (size_t i = 0; i < object->l; ++i) {
+                object_t* key = object->children + i * 2;
+                object_t* value = object->children + i * 2 + 1;
+                assert(key->type == type_str);
+
+                pack_object(packer, key);
+                pack_object(packer, value);
+            }
+            return;
+        default:
+            break;
+    }
+
+    throw std::runtime_error("");
+}
+
+bool run_test(uint32_t* hash_out) {
+    try {
+        std::string buffer;
+        msgpack11::Packer packer(buffer);
+        pack_object(packer, root_object);
+        *hash_out = hash_str(*hash_out, buffer.c_str(), buffer.size());
+    } catch (std::exception e) {
+        return false;
+    }
+    return true;
+}
+
+bool setup_test(size_t object_size) {
+    root_object = benchmark_object_create(object_size);
+    return true;
+}
+
+void teardown_test(void) {
+    object_destroy(root_object);
+}
+
+bool is_benchmark(void) {
+    return true;
+}
+
+const char* test_version(void) {
+    return "0.0.9";
+}
+
+const char* test_language(void) {
+    return BENCHMARK_LANGUAGE_CXX;
+}
+
+const char* test_format(void) {
+    return "MessagePack";
+}
+
+const char* test_filename(void) {
+    return __FILE__;
+}
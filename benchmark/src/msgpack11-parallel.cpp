@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2016 Nicholas Fraser
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "msgpack11.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Thread scaling of parse_parallel() on one large top-level array and of
+// parse_multi_parallel() on the same elements written as concatenated
+// messages. Not a run of the common harness: that times a single
+// configuration, while this prints the time for every thread count from 1
+// up to the number given on the command line (by default, one per core).
+
+namespace {
+
+msgpack11::MsgPack::array make_elements(size_t count) {
+    msgpack11::MsgPack::array elements;
+    elements.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        elements.push_back(msgpack11::MsgPack::object{
+            { "index", static_cast<uint64_t>(i) },
+            { "name", "item-" + std::to_string(i) },
+            { "values", msgpack11::MsgPack::array{ 1.5, -2, static_cast<uint32_t>(i * 7919) } },
+            { "blob", msgpack11::MsgPack::binary(64, static_cast<uint8_t>(i)) }
+        });
+    }
+    return elements;
+}
+
+// Best of several runs, in milliseconds.
+template <typename F>
+double best_of(int runs, F&& f) {
+    double best = 1e300;
+    for (int i = 0; i < runs; ++i) {
+        auto const start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::milli> const elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+}
+
+int main(int argc, char** argv) {
+    unsigned const cores = std::max(std::thread::hardware_concurrency(), 1u);
+    unsigned const max_threads = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1])) : cores;
+    size_t const count = argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 200000;
+
+    msgpack11::MsgPack::array const elements = make_elements(count);
+    std::string const array = msgpack11::MsgPack(elements).dump();
+    std::string stream;
+    for (const auto& element : elements)
+        element.dump_to(stream);
+
+    std::string err;
+    double const sequential_array = best_of(5, [&] { msgpack11::MsgPack::parse(array, err); });
+    double const sequential_stream = best_of(5, [&] { msgpack11::MsgPack::parse_multi(stream, err); });
+
+    printf("%zu elements, %zu bytes\n", count, array.size());
+    printf("threads    array ms  speedup   stream ms  speedup\n");
+    printf("sequential %8.2f           %9.2f\n", sequential_array, sequential_stream);
+    for (unsigned threads = 1; threads <= max_threads; ++threads) {
+        double const parallel_array = best_of(5, [&] { msgpack11::MsgPack::parse_parallel(array, err, {}, threads); });
+        double const parallel_stream = best_of(5, [&] {
+            std::string::size_type stop;
+            msgpack11::MsgPack::parse_multi_parallel(stream, stop, err, {}, threads);
+        });
+        printf("%10u %8.2f %7.2fx %9.2f %7.2fx\n", threads,
+                parallel_array, sequential_array / parallel_array,
+                parallel_stream, sequential_stream / parallel_stream);
+    }
+    if (!err.empty()) {
+        fprintf(stderr, "parse failed: %s\n", err.c_str());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2016 Nicholas Fraser
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark.h"
+#include "msgpack11.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+// Measures a hash_object-style walk over an already parsed tree, which is
+// dominated by type() and the is_*() predicates rather than by decoding.
+
+static msgpack11::MsgPack root;
+
+static uint32_t hash_object(const msgpack11::MsgPack& pack, uint32_t hash) {
+    if (pack.is_null())
+        return hash_nil(hash);
+    if (pack.is_boolean())
+        return hash_bool(hash, pack.as<bool>());
+    if (pack.is_float32() || pack.is_float64())
+        return hash_double(hash, pack.as<double>());
+    if (pack.is_int()) {
+        if (pack.is_int8() || pack.is_int16() || pack.is_int32() || pack.is_int64())
+            return hash_i64(hash, pack.as<int64_t>());
+        return hash_u64(hash, pack.as<uint64_t>());
+    }
+    switch (pack.type()) {
+        case msgpack11::MsgPack::Type::STRING: {
+            std::string const& str = pack.as<msgpack11::MsgPack::string>();
+            return hash_str(hash, str.c_str(), str.size());
+        }
+        case msgpack11::MsgPack::Type::ARRAY: {
+            msgpack11::MsgPack::array const& items = pack.as<msgpack11::MsgPack::array>();
+            std::for_each(items.begin(), items.end(), [&hash](msgpack11::MsgPack const& item) {
+                hash = hash_object(item, hash);
+            });
+            return hash_u32(hash, items.size());
+        }
+        case msgpack11::MsgPack::Type::OBJECT: {
+            msgpack11::MsgPack::object const& items = pack.as<msgpack11::MsgPack::object>();
+            std::for_each(items.begin(), items.end(), [&hash](std::pair<const msgpack11::MsgPack, msgpack11::MsgPack> const& item) {
+                assert(item.first.is_string());
+                std::string const& key_str = item.first.as<msgpack11::MsgPack::string>();
+                hash = hash_str(hash, key_str.c_str(), key_str.size());
+                hash = hash_object(item.second, hash);
+            });
+            return hash_u32(hash, items.size());
+        }
+        default:
+            break;
+    }
+
+    throw std::runtime_error("");
+}
+
+bool run_test(uint32_t* hash_out) {
+    try {
+        *hash_out = hash_object(root, *hash_out);
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+bool setup_test(size_t object_size) {
+    size_t file_size;
+    char* file_data = load_data_file(BENCHMARK_FORMAT_MESSAGEPACK, object_size, &file_size);
+    if (!file_data)
+        return false;
+    std::string err;
+    root = msgpack11::MsgPack::parse(file_data, file_size, err);
+    free(file_data);
+    return err.empty();
+}
+
+void teardown_test(void) {
+    root = msgpack11::MsgPack();
+}
+
+bool is_benchmark(void) {
+    return true;
+}
+
+const char* test_version(void) {
+    return "0.0.9";
+}
+
+const char* test_language(void) {
+    return BENCHMARK_LANGUAGE_CXX;
+}
+
+const char* test_format(void) {
+    return "MessagePack";
+}
+
+const char* test_filename(void) {
+    return __FILE__;
+}
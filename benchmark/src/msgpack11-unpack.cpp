@@ -30,49 +30,49 @@ static size_t file_size;
 
 static uint32_t hash_object(const msgpack11::MsgPack& pack, uint32_t hash) {
     switch (pack.type()) {
-        case msgpack11::MsgPack::NUL:
+        case msgpack11::MsgPack::Type::NUL:
             return hash_nil(hash);
-        case msgpack11::MsgPack::BOOL:
-            return hash_bool(hash, pack.bool_value());
-        case msgpack11::MsgPack::FLOAT32:
-            return hash_double(hash, pack.float32_value());
-        case msgpack11::MsgPack::FLOAT64:
-            return hash_double(hash, pack.float64_value());
-        case msgpack11::MsgPack::INT8:
-            return hash_i64(hash, pack.int8_value());
-        case msgpack11::MsgPack::INT16:
-            return hash_i64(hash, pack.int16_value());
-        case msgpack11::MsgPack::INT32:
-            return hash_i64(hash, pack.int32_value());
-        case msgpack11::MsgPack::INT64:
-            return hash_i64(hash, pack.int64_value());
-        case msgpack11::MsgPack::UINT8:
-            return hash_u64(hash, pack.uint8_value());
-        case msgpack11::MsgPack::UINT16:
-            return hash_u64(hash, pack.uint16_value());
-        case msgpack11::MsgPack::UINT32:
-            return hash_u64(hash, pack.uint32_value());
-        case msgpack11::MsgPack::UINT64:
-            return hash_u64(hash, pack.uint64_value());
-        case msgpack11::MsgPack::STRING: {
-            std::string const& str = pack.string_value();
+        case msgpack11::MsgPack::Type::BOOL:
+            return hash_bool(hash, pack.as<bool>());
+        case msgpack11::MsgPack::Type::FLOAT32:
+            return hash_double(hash, pack.as<float>());
+        case msgpack11::MsgPack::Type::FLOAT64:
+            return hash_double(hash, pack.as<double>());
+        case msgpack11::MsgPack::Type::INT8:
+            return hash_i64(hash, pack.as<int8_t>());
+        case msgpack11::MsgPack::Type::INT16:
+            return hash_i64(hash, pack.as<int16_t>());
+        case msgpack11::MsgPack::Type::INT32:
+            return hash_i64(hash, pack.as<int32_t>());
+        case msgpack11::MsgPack::Type::INT64:
+            return hash_i64(hash, pack.as<int64_t>());
+        case msgpack11::MsgPack::Type::UINT8:
+            return hash_u64(hash, pack.as<uint8_t>());
+        case msgpack11::MsgPack::Type::UINT16:
+            return hash_u64(hash, pack.as<uint16_t>());
+        case msgpack11::MsgPack::Type::UINT32:
+            return hash_u64(hash, pack.as<uint32_t>());
+        case msgpack11::MsgPack::Type::UINT64:
+            return hash_u64(hash, pack.as<uint64_t>());
+        case msgpack11::MsgPack::Type::STRING: {
+            std::string const& str = pack.as<msgpack11::MsgPack::string>();
             return hash_str(hash, str.c_str(), str.size());
         }
-        case msgpack11::MsgPack::ARRAY: {
-            msgpack11::MsgPack::array const& items = pack.array_items();
+        case msgpack11::MsgPack::Type::ARRAY: {
+            msgpack11::MsgPack::array const& items = pack.as<msgpack11::MsgPack::array>();
             std::for_each(items.begin(), items.end(), [&hash](msgpack11::MsgPack const& item) {
                 hash = hash_object( item, hash );
             });
             return hash_u32(hash, items.size());
         }
-        case msgpack11::MsgPack::OBJECT: {
-            msgpack11::MsgPack::object const& items = pack.object_items();
-            std::for_each(items.begin(), items.end(), [&hash]( std::pair< msgpack11::MsgPack, msgpack11::MsgPack > const& item) {
+        case msgpack11::MsgPack::Type::OBJECT: {
+            msgpack11::MsgPack::object const& items = pack.as<msgpack11::MsgPack::object>();
+            std::for_each(items.begin(), items.end(), [&hash]( std::pair< const msgpack11::MsgPack, msgpack11::MsgPack > const& item) {
                 msgpack11::MsgPack const& key = item.first;
                 msgpack11::MsgPack const& value = item.second;
-                assert(key.type() == msgpack11::MsgPack::STRING);
+                assert(key.is_string());
 
-                std::string const& key_str = key.string_value();
+                std::string const& key_str = key.as<msgpack11::MsgPack::string>();
                 hash = hash_str(hash, key_str.c_str(), key_str.size());
                 hash = hash_object(value, hash);
             });
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2016 Nicholas Fraser
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark.h"
+#include "msgpack11.hpp"
+
+#include <stdexcept>
+
+// Reads three header fields out of a large message through MsgPackView.
+// The payload sits in front of them, so every lookup has to skip it by its
+// length headers; none of it is decoded.
+
+static std::string encoded;
+
+bool run_test(uint32_t* hash_out) {
+    try {
+        msgpack11::MsgPackView message(encoded);
+        uint32_t hash = *hash_out;
+        hash = hash_u64(hash, message["id"].as<uint64_t>());
+        std::string_view route = message["route"].as<std::string_view>();
+        hash = hash_str(hash, route.data(), route.size());
+        hash = hash_u64(hash, message["priority"].as<uint64_t>());
+        *hash_out = hash;
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+bool setup_test(size_t object_size) {
+    size_t const count = size_t(1) << (2 * object_size + 4);
+    msgpack11::MsgPack::array payload;
+    for (size_t i = 0; i < count; ++i) {
+        payload.push_back(msgpack11::MsgPack::object{
+            { "index", static_cast<uint64_t>(i) },
+            { "name", "item-" + std::to_string(i) },
+            { "values", msgpack11::MsgPack::array{ 1.5, -2, static_cast<uint32_t>(i * 7919) } },
+            { "blob", msgpack11::MsgPack::binary(64, static_cast<uint8_t>(i)) }
+        });
+    }
+    // Write the fields out in a fixed order, payload first.
+    std::string out = "\x84";
+    out += msgpack11::MsgPack("payload").dump() + msgpack11::MsgPack(payload).dump();
+    out += msgpack11::MsgPack("id").dump() + msgpack11::MsgPack(static_cast<uint64_t>(123456789)).dump();
+    out += msgpack11::MsgPack("route").dump() + msgpack11::MsgPack("eu-west/ingest").dump();
+    out += msgpack11::MsgPack("priority").dump() + msgpack11::MsgPack(static_cast<uint64_t>(3)).dump();
+    encoded = out;
+    return true;
+}
+
+void teardown_test(void) {
+    encoded.clear();
+}
+
+bool is_benchmark(void) {
+    return true;
+}
+
+const char* test_version(void) {
+    return "0.0.9";
+}
+
+const char* test_language(void) {
+    return BENCHMARK_LANGUAGE_CXX;
+}
+
+const char* test_format(void) {
+    return "MessagePack";
+}
+
+const char* test_filename(void) {
+    return __FILE__;
+}
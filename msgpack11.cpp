@@ -1,88 +1,190 @@
 #include "msgpack11.hpp"
-#include "..\h\none.h"
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <limits>
-#include <deque>
+#include <vector>
 #include <tuple>
 #include <algorithm>
-#include <functional>
 #include <exception>
 #include <stdexcept>
 #include <type_traits>
-#include <typeindex>
 #include <utility>
 #include <bit>
 #include <unordered_map>
 #include <map>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace msgpack11
 {
-//	static const int max_depth = 200;
-	
-	constexpr std::partial_ordering operator<=>(const std::unordered_map<MsgPack,MsgPack>&,const std::unordered_map<MsgPack,MsgPack>&)
+	constexpr std::partial_ordering operator<=>(const MsgPack::object&,const MsgPack::object&)
 	{
 		return std::partial_ordering::unordered;
 	}
 	
-	/* Helper for representing null - just a do-nothing struct, plus comparison
- * operators so the helpers in MsgPackValue work. We can't use nullptr_t because
- * it may not be orderable.
- */
-	
 	/* * * * * * * * * * * * * * * * * * * *
  * MasPackValue
  */
 	
+	template<typename T>
+	constexpr MsgPack::Type type_of=MsgPack::Type::INT;
+	template<> constexpr MsgPack::Type type_of<MsgPack::float32>  =MsgPack::Type::FLOAT32;
+	template<> constexpr MsgPack::Type type_of<MsgPack::float64>  =MsgPack::Type::FLOAT64;
+	template<> constexpr MsgPack::Type type_of<MsgPack::int8>     =MsgPack::Type::INT8;
+	template<> constexpr MsgPack::Type type_of<MsgPack::int16>    =MsgPack::Type::INT16;
+	template<> constexpr MsgPack::Type type_of<MsgPack::int32>    =MsgPack::Type::INT32;
+	template<> constexpr MsgPack::Type type_of<MsgPack::int64>    =MsgPack::Type::INT64;
+	template<> constexpr MsgPack::Type type_of<MsgPack::uint8>    =MsgPack::Type::UINT8;
+	template<> constexpr MsgPack::Type type_of<MsgPack::uint16>   =MsgPack::Type::UINT16;
+	template<> constexpr MsgPack::Type type_of<MsgPack::uint32>   =MsgPack::Type::UINT32;
+	template<> constexpr MsgPack::Type type_of<MsgPack::uint64>   =MsgPack::Type::UINT64;
+	template<> constexpr MsgPack::Type type_of<MsgPack::boolean>  =MsgPack::Type::BOOL;
+	template<> constexpr MsgPack::Type type_of<MsgPack::string>   =MsgPack::Type::STRING;
+	template<> constexpr MsgPack::Type type_of<MsgPack::binary>   =MsgPack::Type::BINARY;
+	template<> constexpr MsgPack::Type type_of<MsgPack::array>    =MsgPack::Type::ARRAY;
+	template<> constexpr MsgPack::Type type_of<MsgPack::object>   =MsgPack::Type::OBJECT;
+	template<> constexpr MsgPack::Type type_of<MsgPack::extension> =MsgPack::Type::EXTENSION;
+	template<> constexpr MsgPack::Type type_of<std::string_view>  =MsgPack::Type::STRING;
+	template<> constexpr MsgPack::Type type_of<std::span<const uint8_t>> =MsgPack::Type::BINARY;
+	
+	const char* type_name(MsgPack::Type type)
+	{
+		switch(type)
+		{
+			case MsgPack::Type::NUMBER    : return "number";
+			case MsgPack::Type::INT       : return "int";
+			case MsgPack::Type::NUL       : return "nil";
+			case MsgPack::Type::FLOAT32   : return "float32";
+			case MsgPack::Type::FLOAT64   : return "float64";
+			case MsgPack::Type::INT8      : return "int8";
+			case MsgPack::Type::INT16     : return "int16";
+			case MsgPack::Type::INT32     : return "int32";
+			case MsgPack::Type::INT64     : return "int64";
+			case MsgPack::Type::UINT8     : return "uint8";
+			case MsgPack::Type::UINT16    : return "uint16";
+			case MsgPack::Type::UINT32    : return "uint32";
+			case MsgPack::Type::UINT64    : return "uint64";
+			case MsgPack::Type::BOOL      : return "bool";
+			case MsgPack::Type::STRING    : return "string";
+			case MsgPack::Type::BINARY    : return "binary";
+			case MsgPack::Type::ARRAY     : return "array";
+			case MsgPack::Type::OBJECT    : return "object";
+			case MsgPack::Type::EXTENSION : return "extension";
+		}
+		return "unknown";
+	}
+	
 	class TypeError : public std::runtime_error
 	{
 	public:
-		TypeError(std::type_index expected,std::type_index got):
-			std::runtime_error(std::string()+"expected "+expected.name()+", but got "+got.name()){}
+		TypeError(MsgPack::Type expected,MsgPack::Type got):
+			std::runtime_error(std::string()+"expected "+type_name(expected)+", but got "+type_name(got)){}
 			~TypeError()=default;
 	};
 	
+	namespace
+	{
+		class RawWriter;
+		
+		// Bumped when a value counted by more than one cached container first
+		// hands out a mutable reference; caches taken under an older epoch
+		// are stale. See MsgPackValue::mark_mutated().
+		std::atomic<uint64_t> size_epoch{1};
+	}
+	size_t size_msgpack(const MsgPack& msgpack, bool& cacheable);
+	const MsgPackValue* value_of(const MsgPack& msgpack);
+	template<typename Writer>
+	void dump_msgpack(const MsgPack& msgpack, Writer& out);
+	void canonical_msgpack(const MsgPack& msgpack, std::string& out, bool& cacheable);
+	
+	// Only heap-held values (strings, binaries, arrays, objects and extensions)
+	// are represented by a MsgPackValue; nil, booleans and numbers are stored
+	// inline in MsgPack itself.
 	class MsgPackValue
 	{
 	public:
-		MsgPack::Type type()                                            const;
+		explicit MsgPackValue(MsgPack::Type type):m_type(type){}
+		MsgPack::Type type()                                            const{return m_type;}
 		virtual bool operator==(const MsgPackValue &other)              const=0;
 		virtual std::partial_ordering operator<=>(const MsgPackValue&)  const=0;
-		virtual void dump(std::ostream& os)                             const=0;
+		virtual size_t encoded_size(bool& cacheable)                    const=0;
+		virtual void dump(RawWriter& out)                               const=0;
+		// Append the canonical encoding; cacheable as for encoded_size().
+		virtual void dump_canonical(std::string& out, bool& cacheable)  const=0;
+		// The same for the value dump(Canonical) was called on, which an
+		// array or object answers from a copy it keeps; see CanonicalCache.
+		virtual void dump_canonical_root(std::string& out)               const
+		{
+			bool cacheable=true;
+			dump_canonical(out, cacheable);
+		}
+		// Called before a mutable reference into this value is handed out.
+		// The value can then change behind our back, so it and everything
+		// holding it stop caching their encoded size for good. The caches
+		// already taken are dropped along the chain of containers counting
+		// this value, which leaves unrelated trees alone.
+		void mark_mutated()
+		{
+			if(m_mutated.load(std::memory_order_relaxed) || m_mutated.exchange(true))
+				return;
+			for(const MsgPackValue* node=this; node; node=node->m_parent.load(std::memory_order_acquire))
+			{
+				if(node==shared_parent())
+				{
+					size_epoch.fetch_add(1, std::memory_order_release);
+					break;
+				}
+				node->forget();
+			}
+			// Members may now be swapped out, and this value never caches
+			// again, so they no longer report to it.
+			unlink_members();
+		}
+		bool mutated()                                                  const{return m_mutated.load(std::memory_order_relaxed);}
+		// Set on the nodes of a Document, which are never destroyed, so
+		// they must not take on heap memory after the parse.
+		void mark_in_arena()                                                 {m_in_arena=true;}
+		bool in_arena()                                                 const{return m_in_arena;}
+		// Record that parent's cache counts this value, so that mutating it
+		// reaches parent. A value counted by two containers cannot tell
+		// them apart and falls back to bumping size_epoch.
+		void link(const MsgPackValue* parent) const
+		{
+			const MsgPackValue* expected=m_parent.load(std::memory_order_acquire);
+			if(!expected && m_parent.compare_exchange_strong(expected, parent, std::memory_order_acq_rel))
+				return;
+			if(expected!=parent && expected!=shared_parent())
+				m_parent.store(shared_parent(), std::memory_order_release);
+		}
+		void unlink(const MsgPackValue* parent) const
+		{
+			if(m_parent.load(std::memory_order_relaxed)==parent)
+				m_parent.compare_exchange_strong(parent, nullptr, std::memory_order_acq_rel);
+		}
 		//immutable type specify
-		virtual explicit operator MsgPack::float32          ()const;
-		virtual explicit operator MsgPack::float64          ()const;
-		virtual explicit operator MsgPack::int128           ()const;
-		virtual explicit operator MsgPack::int8             ()const;
-		virtual explicit operator MsgPack::int16            ()const;
-		virtual explicit operator MsgPack::int32            ()const;
-		virtual explicit operator MsgPack::int64            ()const;
-		virtual explicit operator MsgPack::uint8            ()const;
-		virtual explicit operator MsgPack::uint16           ()const;
-		virtual explicit operator MsgPack::uint32           ()const;
-		virtual explicit operator MsgPack::uint64           ()const;
-		virtual explicit operator MsgPack::boolean          ()const;
 		virtual explicit operator MsgPack::string    const &()const;
 		virtual explicit operator MsgPack::array     const &()const;
 		virtual explicit operator MsgPack::binary    const &()const;
 		virtual explicit operator MsgPack::object    const &()const;
 		virtual explicit operator MsgPack::extension const &()const;
+		//strings and binaries in place
+		virtual explicit operator std::string_view           ()const;
+		virtual explicit operator std::span<const uint8_t>   ()const;
 		//mutable type specify
-		virtual explicit operator MsgPack::float32    &();
-		virtual explicit operator MsgPack::float64    &();
-		virtual explicit operator MsgPack::int128     &();
-		virtual explicit operator MsgPack::int8       &();
-		virtual explicit operator MsgPack::int16      &();
-		virtual explicit operator MsgPack::int32      &();
-		virtual explicit operator MsgPack::int64      &();
-		virtual explicit operator MsgPack::uint8      &();
-		virtual explicit operator MsgPack::uint16     &();
-		virtual explicit operator MsgPack::uint32     &();
-		virtual explicit operator MsgPack::uint64     &();
-		virtual explicit operator MsgPack::boolean    &();
 		virtual explicit operator MsgPack::string     &();
 		virtual explicit operator MsgPack::array      &();
 		virtual explicit operator MsgPack::binary     &();
@@ -94,489 +196,1311 @@ namespace msgpack11
 		virtual MsgPack            const &operator[](const MsgPack &key)const;
 		virtual MsgPack                  &operator[](const MsgPack &key);
 		virtual ~MsgPackValue()=default;
+	protected:
+		// Drop what this value has cached.
+		virtual void forget() const
+		{
+			m_size_epoch.store(0, std::memory_order_release);
+		}
+		// Unlink the members of an array or object from it.
+		virtual void unlink_members() const {}
+		// Return the size cached for the current epoch, or compute(cacheable)
+		// it and remember the result if nothing below was mutated.
+		template<typename F>
+		size_t cached_size(bool& cacheable, F&& compute) const
+		{
+			uint64_t const epoch=size_epoch.load(std::memory_order_acquire);
+			if(m_size_epoch.load(std::memory_order_acquire)==epoch)
+				return m_size.load(std::memory_order_relaxed);
+			bool subtree=!mutated();
+			size_t const size=compute(subtree);
+			if(subtree)
+			{
+				m_size.store(size, std::memory_order_relaxed);
+				m_size_epoch.store(epoch, std::memory_order_release);
+			}
+			else
+			{
+				cacheable=false;
+			}
+			return size;
+		}
+	private:
+		static const MsgPackValue* shared_parent()
+		{
+			alignas(MsgPackValue) static const char tag=0;
+			return reinterpret_cast<const MsgPackValue*>(&tag);
+		}
+		
+		// Set once by the concrete value class, so type() needs neither RTTI
+		// nor a lookup.
+		const MsgPack::Type m_type;
+		std::atomic<bool> m_mutated{false};
+		bool m_in_arena=false;
+		// The container whose cache counts this value, or shared_parent().
+		mutable std::atomic<const MsgPackValue*> m_parent{nullptr};
+		mutable std::atomic<uint64_t> m_size_epoch{0};
+		mutable std::atomic<size_t> m_size{0};
 	};
 	
+	// Call visitor with the inline scalar payload, or with nullptr for nil and
+	// for heap-held values.
+	template<typename F>
+	auto MsgPack::visit_scalar(F&& visitor) const
+	{
+		switch(m_type)
+		{
+			case Type::FLOAT32 : return visitor(m_float32);
+			case Type::FLOAT64 : return visitor(m_float64);
+			case Type::INT8    : return visitor(m_int8);
+			case Type::INT16   : return visitor(m_int16);
+			case Type::INT32   : return visitor(m_int32);
+			case Type::INT64   : return visitor(m_int64);
+			case Type::UINT8   : return visitor(m_uint8);
+			case Type::UINT16  : return visitor(m_uint16);
+			case Type::UINT32  : return visitor(m_uint32);
+			case Type::UINT64  : return visitor(m_uint64);
+			case Type::BOOL    : return visitor(m_boolean);
+			default            : return visitor(nullptr);
+		}
+	}
+	
 	/* * * * * * * * * * * * * * * * * * * *
  * Serialization
  */
 	
 	namespace
 	{
-		static const union
+		/* Byte order
+ *
+ * MessagePack stores multi-byte values big-endian. They are moved with one
+ * unaligned load or store and, on little-endian hosts, one byte swap.
+ * std::byteswap is C++23, hence the local helper.
+ */
+		template<size_t N>
+		using uint_of_size=std::conditional_t<N==1,uint8_t,
+			std::conditional_t<N==2,uint16_t,
+			std::conditional_t<N==4,uint32_t,uint64_t>>>;
+		
+		template<typename U>
+		constexpr U byteswap(U value)
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			if constexpr(sizeof(U)==2)
+				return __builtin_bswap16(value);
+			else if constexpr(sizeof(U)==4)
+				return __builtin_bswap32(value);
+			else if constexpr(sizeof(U)==8)
+				return __builtin_bswap64(value);
+			else
+				return value;
+#else
+			U ret=0;
+			for(size_t i=0;i<sizeof(U);++i)
+			{
+				ret=static_cast<U>((ret<<8)|(value&0xff));
+				value=static_cast<U>(value>>8);
+			}
+			return ret;
+#endif
+		}
+		
+		template<typename T> requires std::is_trivially_copyable_v<T>
+		inline T load_big_endian(const uint8_t* src)
+		{
+			uint_of_size<sizeof(T)> raw;
+			static_assert(sizeof(raw)==sizeof(T));
+			std::memcpy(&raw, src, sizeof(T));
+			if constexpr(std::endian::native==std::endian::little)
+				raw=byteswap(raw);
+			return std::bit_cast<T>(raw);
+		}
+		
+		template<typename T> requires std::is_trivially_copyable_v<T>
+		inline void store_big_endian(const T& value, uint8_t* dst)
 		{
-			uint16_t dummy;
-			uint8_t bytes[2];
-		} endian_check_data { 0x0001 };
-		static const bool is_big_endian = endian_check_data.bytes[0] == 0x00;
+			auto raw=std::bit_cast<uint_of_size<sizeof(T)>>(value);
+			if constexpr(std::endian::native==std::endian::little)
+				raw=byteswap(raw);
+			std::memcpy(dst, &raw, sizeof(T));
+		}
 		
-		template< typename T > requires std::is_trivially_copyable_v<T>
-		void dump_data(const T& value, std::ostream& os)
+		/* Output
+ *
+ * MsgPack::dump_to() measures the value with encoded_size() first, grows the
+ * buffer once and then writes through a RawWriter, which needs neither
+ * reallocation nor bounds checks.
+ */
+		class RawWriter
 		{
-			union
+		public:
+			explicit RawWriter(uint8_t* cur):m_cur(cur){}
+			void put(uint8_t byte)
 			{
-				T packed;
-				std::array<uint8_t, sizeof(T)> bytes;
-			} converter;
-			converter.packed=value;
-			
-			int const n = sizeof(T);
-			int const offsets[] = {(n-1), 0};
-			int const directions[] = {-1, 1};
-			uint8_t const off = offsets[static_cast<int>(is_big_endian)];
-			int const dir = directions[static_cast<int>(is_big_endian)];
-			for(int i = 0; i < n; ++i)
+				*m_cur++=byte;
+			}
+			void write(const void* data, size_t n)
+			{
+				m_cur=std::copy_n(static_cast<const uint8_t*>(data), n, m_cur);
+			}
+			uint8_t* position() const{return m_cur;}
+		private:
+			uint8_t* m_cur;
+		};
+		
+		/* Encoded sizes
+ *
+ * Each overload mirrors the header selection of the dump() overload for the
+ * same type below; keep the two in step.
+ */
+		inline size_t encoded_size(std::nullptr_t)         { return 1; }
+		inline size_t encoded_size(MsgPack::float32)       { return 5; }
+		inline size_t encoded_size(MsgPack::float64)       { return 9; }
+		inline size_t encoded_size(MsgPack::boolean)       { return 1; }
+		inline size_t encoded_size(uint8_t value)          { return value < 128 ? 1 : 2; }
+		inline size_t encoded_size(uint16_t value)         { return value < (1<<8) ? encoded_size(static_cast<uint8_t>(value)) : 3; }
+		inline size_t encoded_size(uint32_t value)         { return value < (1<<16) ? encoded_size(static_cast<uint16_t>(value)) : 5; }
+		inline size_t encoded_size(uint64_t value)         { return value < (1ULL<<32) ? encoded_size(static_cast<uint32_t>(value)) : 9; }
+		inline size_t encoded_size(int8_t value)           { return value < -32 ? 2 : 1; }
+		
+		inline size_t encoded_size(int16_t value)
+		{
+			if( value < -(1 << 7) )
+				return 3;
+			if( value <= 0 )
+				return encoded_size(static_cast<int8_t>(value));
+			return encoded_size(static_cast<uint16_t>(value));
+		}
+		
+		inline size_t encoded_size(int32_t value)
+		{
+			if( value < -(1 << 15) )
+				return 5;
+			if( value <= 0 )
+				return encoded_size(static_cast<int16_t>(value));
+			return encoded_size(static_cast<uint32_t>(value));
+		}
+		
+		inline size_t encoded_size(int64_t value)
+		{
+			if( value < -(1LL << 31) )
+				return 9;
+			if( value <= 0 )
+				return encoded_size(static_cast<int32_t>(value));
+			return encoded_size(static_cast<uint64_t>(value));
+		}
+		
+		inline size_t encoded_size(std::string_view value)
+		{
+			size_t const len = value.size();
+			if(len <= 0x1f)
+				return 1+len;
+			if(len <= 0xff)
+				return 2+len;
+			if(len <= 0xffff)
+				return 3+len;
+			if(len <= 0xffffffff)
+				return 5+len;
+			throw std::runtime_error("exceeded maximum data length");
+		}
+		
+		inline size_t encoded_size(std::span<const uint8_t> value)
+		{
+			size_t const len = value.size();
+			if(len <= 0xff)
+				return 2+len;
+			if(len <= 0xffff)
+				return 3+len;
+			if(len <= 0xffffffff)
+				return 5+len;
+			throw std::runtime_error("exceeded maximum data length");
+		}
+		
+		inline size_t encoded_extension_size(size_t len)
+		{
+			switch(len)
+			{
+				case 0x01: case 0x02: case 0x04: case 0x08: case 0x10:
+					return 2+len;
+			}
+			if(len <= 0xff)
+				return 3+len;
+			if(len <= 0xffff)
+				return 4+len;
+			if(len <= 0xffffffff)
+				return 6+len;
+			throw std::runtime_error("exceeded maximum data length");
+		}
+		
+		inline size_t encoded_size(const MsgPack::extension& value)
+		{
+			return encoded_extension_size(std::get<1>(value).size());
+		}
+		
+		// Headers of arrays and maps, without their members.
+		inline size_t encoded_header_size(size_t len)
+		{
+			return len <= 15 ? 1 : len <= 0xffff ? 3 : 5;
+		}
+		
+		// Point member at parent, unless there is none to point at; see
+		// MsgPackValue::mark_mutated().
+		inline void link_member(const MsgPack& member, const MsgPackValue* parent)
+		{
+			if(const MsgPackValue* node=value_of(member); node && parent)
+				node->link(parent);
+		}
+		
+		// cacheable is cleared when some value below has handed out a mutable
+		// reference, see MsgPackValue::mark_mutated(). The members are linked
+		// to parent on the way.
+		inline size_t encoded_size(const MsgPack::array& value, bool& cacheable, const MsgPackValue* parent)
+		{
+			size_t const len = value.size();
+			size_t size;
+			if(len <= 15)
+				size = 1;
+			else if(len <= 0xffff)
+				size = 3;
+			else if(len <= 0xffffffff)
+				size = 5;
+			else
+				throw std::runtime_error("exceeded maximum data length");
+			for(const auto& v:value)
+			{
+				link_member(v, parent);
+				size += size_msgpack(v, cacheable);
+			}
+			return size;
+		}
+		
+		inline size_t encoded_size(const MsgPack::object& value, bool& cacheable, const MsgPackValue* parent)
+		{
+			size_t const len = value.size();
+			size_t size;
+			if(len <= 15)
+				size = 1;
+			else if(len <= 0xffff)
+				size = 3;
+			else if(len <= 0xffffffff)
+				size = 5;
+			else
+				throw std::runtime_error("too long value.");
+			for(const auto& v:value)
 			{
-				os.put(converter.bytes[off + dir * i]);
+				link_member(v.first, parent);
+				link_member(v.second, parent);
+				size += size_msgpack(v.first, cacheable) + size_msgpack(v.second, cacheable);
 			}
+			return size;
 		}
 		
-		inline void dump(reverSilly::none, std::ostream& os)
+		// Write a type marker followed by a big-endian value in a single store.
+		template<typename Writer, typename T>
+		inline void dump_header(uint8_t marker, const T& value, Writer& out)
 		{
-			os.put(0xc0);
+			uint8_t bytes[1+sizeof(T)];
+			bytes[0]=marker;
+			store_big_endian(value, bytes+1);
+			out.write(bytes, sizeof(bytes));
 		}
 		
-		inline void dump(MsgPack::float32 value, std::ostream& os)
+		template<typename Writer>
+		inline void dump(std::nullptr_t, Writer& out)
 		{
-			os.put(0xca);
-			dump_data(value, os);
+			out.put(0xc0);
 		}
 		
-		inline void dump(MsgPack::float64 value, std::ostream& os)
+		template<typename Writer>
+		inline void dump(MsgPack::float32 value, Writer& out)
 		{
-			os.put(0xcb);
-			dump_data(value, os);
+			dump_header(0xca, value, out);
 		}
 		
-		inline void dump(uint8_t value, std::ostream& os)
+		template<typename Writer>
+		inline void dump(MsgPack::float64 value, Writer& out)
+		{
+			dump_header(0xcb, value, out);
+		}
+		
+		template<typename Writer>
+		inline void dump(uint8_t value, Writer& out)
 		{
 			if(128 <= value)
 			{
-				os.put(0xcc);
+				dump_header(0xcc, value, out);
+			}
+			else
+			{
+				out.put(value);
 			}
-			os.put(value);
 		}
 		
-		inline void dump(uint16_t value, std::ostream& os)
+		template<typename Writer>
+		inline void dump(uint16_t value, Writer& out)
 		{
 			if( value < (1<<8) )
 			{
-				dump(static_cast<uint8_t>(value), os );
+				dump(static_cast<uint8_t>(value), out );
 			}
 			else
 			{
-				os.put(0xcd);
-				dump_data(value, os);
+				dump_header(0xcd, value, out);
 			}
 		}
 		
-		inline void dump(uint32_t value, std::ostream& os)
+		template<typename Writer>
+		inline void dump(uint32_t value, Writer& out)
 		{
 			if( value < (1 << 16) )
 			{
-				dump(static_cast<uint16_t>(value), os );
+				dump(static_cast<uint16_t>(value), out );
 			}
 			else
 			{
-				os.put(0xce);
-				dump_data(value, os);
+				dump_header(0xce, value, out);
 			}
 		}
 		
-		inline void dump(uint64_t value, std::ostream& os)
+		template<typename Writer>
+		inline void dump(uint64_t value, Writer& out)
 		{
 			if( value < (1ULL << 32) )
 			{
-				dump(static_cast<uint32_t>(value), os );
+				dump(static_cast<uint32_t>(value), out );
 			}
 			else
 			{
-				os.put(0xcf);
-				dump_data(value, os);
+				dump_header(0xcf, value, out);
 			}
 		}
 		
-		inline void dump(int8_t value, std::ostream& os)
+		template<typename Writer>
+		inline void dump(int8_t value, Writer& out)
 		{
 			if( value < -32 )
 			{
-				os.put(0xd0);
+				dump_header(0xd0, value, out);
+			}
+			else
+			{
+				out.put(value);
 			}
-			os.put(value);
 		}
 		
-		inline void dump(int16_t value, std::ostream& os)
+		template<typename Writer>
+		inline void dump(int16_t value, Writer& out)
 		{
 			if( value < -(1 << 7) )
 			{
-				os.put(0xd1);
-				dump_data(value, os);
+				dump_header(0xd1, value, out);
 			}
 			else if( value <= 0 )
 			{
-				dump(static_cast<int8_t>(value), os );
+				dump(static_cast<int8_t>(value), out );
 			}
 			else
 			{
-				dump(static_cast<uint16_t>(value), os );
+				dump(static_cast<uint16_t>(value), out );
 			}
 		}
 		
-		inline void dump(int32_t value, std::ostream& os)
+		template<typename Writer>
+		inline void dump(int32_t value, Writer& out)
 		{
 			if( value < -(1 << 15) )
 			{
-				os.put(0xd2);
-				dump_data(value, os);
+				dump_header(0xd2, value, out);
 			}
 			else if( value <= 0 )
 			{
-				dump(static_cast<int16_t>(value), os );
+				dump(static_cast<int16_t>(value), out );
 			}
 			else
 			{
-				dump(static_cast<uint32_t>(value), os );
+				dump(static_cast<uint32_t>(value), out );
 			}
 		}
 		
-		inline void dump(int64_t value, std::ostream& os)
+		template<typename Writer>
+		inline void dump(int64_t value, Writer& out)
 		{
 			if( value < -(1LL << 31) )
 			{
-				os.put(0xd3);
-				dump_data(value, os);
+				dump_header(0xd3, value, out);
 			}
 			else if( value <= 0 )
 			{
-				dump(static_cast<int32_t>(value), os );
+				dump(static_cast<int32_t>(value), out );
 			}
 			else
 			{
-				dump(static_cast<uint64_t>(value), os );
+				dump(static_cast<uint64_t>(value), out );
 			}
 		}
 		
-		inline void dump(MsgPack::boolean value, std::ostream& os)
+		template<typename Writer>
+		inline void dump(MsgPack::boolean value, Writer& out)
 		{
 			const uint8_t msgpack_value = (value) ? 0xc3 : 0xc2;
-			os.put(msgpack_value);
+			out.put(msgpack_value);
 		}
 		
-		inline void dump(const std::string& value, std::ostream& os)
+		template<typename Writer>
+		inline void dump_str_header(size_t len, Writer& out)
 		{
-			size_t const len = value.size();
 			if(len <= 0x1f)
 			{
 				uint8_t const first_byte = 0xa0 | static_cast<uint8_t>(len);
-				os.put(first_byte);
+				out.put(first_byte);
 			}
 			else if(len <= 0xff)
 			{
-				os.put(0xd9);
-				os.put(static_cast<uint8_t>(len));
+				dump_header(0xd9, static_cast<uint8_t>(len), out);
 			}
 			else if(len <= 0xffff)
 			{
-				os.put(0xda);
-				dump_data(static_cast<uint16_t>(len), os);
+				dump_header(0xda, static_cast<uint16_t>(len), out);
 			}
 			else if(len <= 0xffffffff)
 			{
-				os.put(0xdb);
-				dump_data(static_cast<uint32_t>(len), os);
+				dump_header(0xdb, static_cast<uint32_t>(len), out);
 			}
 			else
 			{
 				throw std::runtime_error("exceeded maximum data length");
 			}
-			
-			std::for_each(std::begin(value), std::end(value),
-				[&os](char v)
-				{
-					dump_data(v, os);
-				});
 		}
 		
-		inline void dump(const MsgPack::array& value, std::ostream& os)
+		template<typename Writer>
+		inline void dump(std::string_view value, Writer& out)
+		{
+			dump_str_header(value.size(), out);
+			out.write(value.data(), value.size());
+		}
+		
+		template<typename Writer>
+		inline void dump_array_header(size_t len, Writer& out)
 		{
-			size_t const len = value.size();
 			if(len <= 15)
 			{
 				uint8_t const first_byte = 0x90 | static_cast<uint8_t>(len);
-				os.put(first_byte);
+				out.put(first_byte);
 			}
 			else if(len <= 0xffff)
 			{
-				os.put(0xdc);
-				dump_data(static_cast<uint16_t>(len), os);
+				dump_header(0xdc, static_cast<uint16_t>(len), out);
 			}
 			else if(len <= 0xffffffff)
 			{
-				os.put(0xdd);
-				dump_data(static_cast<uint32_t>(len), os);
+				dump_header(0xdd, static_cast<uint32_t>(len), out);
 			}
 			else
 			{
 				throw std::runtime_error("exceeded maximum data length");
 			}
+		}
+		
+		template<typename Writer>
+		inline void dump(const MsgPack::array& value, Writer& out)
+		{
+			dump_array_header(value.size(), out);
 			for(const auto&v:value)
-				os<<v;
+				dump_msgpack(v, out);
 		}
 		
-		inline void dump(const MsgPack::object& value, std::ostream& os)
+		template<typename Writer>
+		inline void dump_map_header(size_t len, Writer& out)
 		{
-			size_t const len = value.size();
 			if(len <= 15)
 			{
 				uint8_t const first_byte = 0x80 | static_cast<uint8_t>(len);
-				os.put(first_byte);
+				out.put(first_byte);
 			}
 			else if(len <= 0xffff)
 			{
-				os.put(0xde);
-				dump_data(static_cast<uint16_t>(len), os);
+				dump_header(0xde, static_cast<uint16_t>(len), out);
 			}
 			else if(len <= 0xffffffff)
 			{
-				os.put(0xdf);
-				dump_data(static_cast<uint32_t>(len), os);
+				dump_header(0xdf, static_cast<uint32_t>(len), out);
 			}
 			else
 			{
 				throw std::runtime_error("too long value.");
 			}
+		}
+		
+		template<typename Writer>
+		inline void dump(const MsgPack::object& value, Writer& out)
+		{
+			dump_map_header(value.size(), out);
 			for(const auto &v:value)
-				os<<v.first<<v.second;
+			{
+				dump_msgpack(v.first, out);
+				dump_msgpack(v.second, out);
+			}
 		}
 		
-		inline void dump(const MsgPack::binary& value, std::ostream& os)
+		template<typename Writer>
+		inline void dump_bin_header(size_t len, Writer& out)
 		{
-			size_t const len = value.size();
 			if(len <= 0xff)
 			{
-				os.put(0xc4);
-				dump_data(static_cast<uint8_t>(len), os);
+				dump_header(0xc4, static_cast<uint8_t>(len), out);
 			}
 			else if(len <= 0xffff)
 			{
-				os.put(0xc5);
-				dump_data(static_cast<uint16_t>(len), os);
+				dump_header(0xc5, static_cast<uint16_t>(len), out);
 			}
 			else if(len <= 0xffffffff)
 			{
-				os.put(0xc6);
-				dump_data(static_cast<uint32_t>(len), os);
+				dump_header(0xc6, static_cast<uint32_t>(len), out);
 			}
 			else
 			{
 				throw std::runtime_error("exceeded maximum data length");
 			}
-			os.write(reinterpret_cast<const char*>(value.data()), value.size());
 		}
 		
-		inline void dump(const MsgPack::extension& value, std::ostream& os)
+		template<typename Writer>
+		inline void dump(std::span<const uint8_t> value, Writer& out)
+		{
+			dump_bin_header(value.size(), out);
+			out.write(value.data(), value.size());
+		}
+		
+		template<typename Writer>
+		inline void dump_ext_header(uint8_t type, size_t len, Writer& out)
 		{
-			const uint8_t type(std::get<0>(value));
-			const MsgPack::binary& data(std::get<1>(value));
-			const size_t len = data.size();
-			
 			if(len == 0x01) {
-				os.put(0xd4);
+				dump_header(0xd4, type, out);
 			}
 			else if(len == 0x02) {
-				os.put(0xd5);
+				dump_header(0xd5, type, out);
 			}
 			else if(len == 0x04) {
-				os.put(0xd6);
+				dump_header(0xd6, type, out);
 			}
 			else if(len == 0x08) {
-				os.put(0xd7);
+				dump_header(0xd7, type, out);
 			}
 			else if(len == 0x10) {
-				os.put(0xd8);
+				dump_header(0xd8, type, out);
 			}
 			else if(len <= 0xff) {
-				os.put(0xc7);
-				os.put(static_cast<uint8_t>(len));
+				uint8_t const bytes[]{0xc7, static_cast<uint8_t>(len), type};
+				out.write(bytes, sizeof(bytes));
 			}
 			else if(len <= 0xffff) {
-				os.put(0xc8);
-				dump_data(static_cast<uint16_t>(len), os);
+				uint8_t bytes[4]{0xc8};
+				store_big_endian(static_cast<uint16_t>(len), bytes+1);
+				bytes[3]=type;
+				out.write(bytes, sizeof(bytes));
 			}
 			else if(len <= 0xffffffff) {
-				os.put(0xc9);
-				dump_data(static_cast<uint32_t>(len), os);
+				uint8_t bytes[6]{0xc9};
+				store_big_endian(static_cast<uint32_t>(len), bytes+1);
+				bytes[5]=type;
+				out.write(bytes, sizeof(bytes));
 			}
 			else {
 				throw std::runtime_error("exceeded maximum data length");
 			}
-			
-			os.put(type);
-			os.write(reinterpret_cast<const char*>(data.data()), data.size());
+		}
+		
+		template<typename Writer>
+		inline void dump_extension(uint8_t type, std::span<const uint8_t> data, Writer& out)
+		{
+			dump_ext_header(type, data.size(), out);
+			out.write(data.data(), data.size());
+		}
+		
+		template<typename Writer>
+		inline void dump(const MsgPack::extension& value, Writer& out)
+		{
+			dump_extension(std::get<0>(value), std::get<1>(value), out);
+		}
+		
+		// Append value as its dump() overload encodes it, measuring it first.
+		template<typename T>
+		void append_encoded(const T& value, std::string& out)
+		{
+			size_t const offset=out.size();
+			out.resize(offset+encoded_size(value));
+			RawWriter writer(reinterpret_cast<uint8_t*>(out.data())+offset);
+			dump(value, writer);
+		}
+		
+		template<typename Buffer>
+		void dump_into(const MsgPack& msgpack, Buffer& out)
+		{
+			size_t const offset=out.size();
+			out.resize(offset+msgpack.encoded_size());
+			RawWriter writer(reinterpret_cast<uint8_t*>(out.data())+offset);
+			dump_msgpack(msgpack, writer);
+			assert(writer.position()==reinterpret_cast<uint8_t*>(out.data())+out.size());
 		}
 	}
 	
-	std::ostream& operator<<(std::ostream& os, const MsgPack& msgpack)
+	size_t size_msgpack(const MsgPack& msgpack, bool& cacheable)
 	{
-		msgpack.m_ptr->dump(os);
-		return os;
+		if(msgpack.m_ptr)
+			return msgpack.m_ptr->encoded_size(cacheable);
+		return msgpack.visit_scalar([](auto value){ return encoded_size(value); });
 	}
 	
-	/* * * * * * * * * * * * * * * * * * * *
- * Value wrappers
- */
-	
-	template <typename T>
-	class Value : public MsgPackValue
+	template<typename Writer>
+	void dump_msgpack(const MsgPack& msgpack, Writer& out)
 	{
-	public:
-		// Constructors
-		Value(T value) requires(std::is_fundamental_v<T>):m_value(value){}
-		Value(const T& value) requires(std::is_class_v<T>):m_value(value){}
-		Value(T&& value) requires(std::is_class_v<T>):m_value(std::move(value)){}
-		Value():m_value(){}
-		// Comparisons
-		virtual bool operator==(const MsgPackValue &other) const override
+		if(msgpack.m_ptr)
 		{
-			return (type()==other.type())&&(m_value==static_cast<const Value<T>&>(other).m_value);
+			msgpack.m_ptr->dump(out);
 		}
-		virtual std::partial_ordering operator<=>(const MsgPackValue &other) const override
+		else
 		{
-			if(type()<=>other.type()!=0)
-				return type()<=>other.type();
-			else
-			{
-				if(type()==other.type())
-					return m_value<=>static_cast<const Value<T>&>(other).m_value;
-				else
-					return std::partial_ordering::unordered;
-			}
+			msgpack.visit_scalar([&out](auto value){ dump(value, out); });
 		}
-		T m_value;
-		virtual void dump(std::ostream& os) const override { msgpack11::dump(m_value, os); }
-		virtual explicit operator T&(){return m_value;}
-	};
+	}
 	
-	template<typename T> requires(std::is_fundamental_v<T>)
-	class Number final: public Value<T>
+	void canonical_msgpack(const MsgPack& msgpack, std::string& out, bool& cacheable)
 	{
-	public:
-		Number(T value):Value<T>(value){}
-		
-		bool operator ==(const MsgPackValue &other) const override
+		if(msgpack.m_ptr)
+			msgpack.m_ptr->dump_canonical(out, cacheable);
+		else
+			dump_into(msgpack, out);
+	}
+	
+	namespace
+	{
+		// Append the canonical encoding of a map, its entries sorted by their
+		// encoded keys. Members are linked to parent on the way, as the sizing
+		// walk does, so that changing one reaches the caches above.
+		void canonical_map(const MsgPack::object& items, const MsgPackValue* parent, std::string& out, bool& cacheable)
 		{
-			switch( other.type() )
+			// Encode the keys back to back, then sort the entries by them.
+			struct Entry
 			{
-				case MsgPack::Type::FLOAT32 : // fall through
-				case MsgPack::Type::FLOAT64 : // fall through
-				{
-					return operator MsgPack::float64()==other.operator MsgPack::float64();
-				} break;
-				case MsgPack::Type::UINT8   : // fall through
-				case MsgPack::Type::UINT16  : // fall through
-				case MsgPack::Type::UINT32  : // fall through
-				case MsgPack::Type::UINT64  : // fall through
-				case MsgPack::Type::INT8    : // fall through
-				case MsgPack::Type::INT16   : // fall through
-				case MsgPack::Type::INT32   : // fall through
-				case MsgPack::Type::INT64   : // fall through
-				{
-					return operator MsgPack::int128()==other.operator MsgPack::int128();
-				} break;
-				default:
-					{
-						return Value<T>::operator ==(other);
-					} break;
+				size_t offset;
+				size_t size;
+				const MsgPack* value;
+			};
+			std::string keys;
+			std::vector<Entry> entries;
+			entries.reserve(items.size());
+			for(const auto& item:items)
+			{
+				link_member(item.first, parent);
+				link_member(item.second, parent);
+				size_t const offset=keys.size();
+				canonical_msgpack(item.first, keys, cacheable);
+				entries.push_back({offset, keys.size()-offset, &item.second});
 			}
-		}
+			auto const key=[&keys](const Entry& entry){ return std::string_view(keys).substr(entry.offset, entry.size); };
+			std::sort(entries.begin(), entries.end(), [&key](const Entry& lhs, const Entry& rhs){ return key(lhs)<key(rhs); });
 		
-		std::partial_ordering operator<=>(const MsgPackValue &other) const override
-		{
-			switch( other.type() )
+			size_t const offset=out.size();
+			out.resize(offset+encoded_header_size(items.size()));
+			RawWriter header(reinterpret_cast<uint8_t*>(out.data())+offset);
+			dump_map_header(items.size(), header);
+			for(const Entry& entry:entries)
 			{
-				case MsgPack::Type::FLOAT32 : // fall through
-				case MsgPack::Type::FLOAT64 : // fall through
-				{
-					return operator MsgPack::float64()<=>other.operator MsgPack::float64();
-				} break;
-				case MsgPack::Type::UINT8   : // fall through
-				case MsgPack::Type::UINT16  : // fall through
-				case MsgPack::Type::UINT32  : // fall through
-				case MsgPack::Type::UINT64  : // fall through
-				case MsgPack::Type::INT8    : // fall through
-				case MsgPack::Type::INT16   : // fall through
-				case MsgPack::Type::INT32   : // fall through
-				case MsgPack::Type::INT64   : // fall through
-				{
-					return operator MsgPack::int128()<=>other.operator MsgPack::int128();
-				} break;
-				default:
-					{
-						return Value<T>::operator<=>(other);
-					} break;
-			}
-		}
-		virtual explicit operator MsgPack::float32   ()const override{return static_cast<MsgPack::float32>(Value<T>::m_value);}
-		virtual explicit operator MsgPack::float64   ()const override{return static_cast<MsgPack::float64>(Value<T>::m_value);}
-		virtual explicit operator MsgPack::int8      ()const override{return static_cast<MsgPack::int8>   (Value<T>::m_value);}
-		virtual explicit operator MsgPack::int16     ()const override{return static_cast<MsgPack::int16>  (Value<T>::m_value);}
-		virtual explicit operator MsgPack::int32     ()const override{return static_cast<MsgPack::int32>  (Value<T>::m_value);}
-		virtual explicit operator MsgPack::int64     ()const override{return static_cast<MsgPack::int64>  (Value<T>::m_value);}
-		virtual explicit operator MsgPack::uint8     ()const override{return static_cast<MsgPack::uint8>  (Value<T>::m_value);}
-		virtual explicit operator MsgPack::uint16    ()const override{return static_cast<MsgPack::uint16> (Value<T>::m_value);}
-		virtual explicit operator MsgPack::uint32    ()const override{return static_cast<MsgPack::uint32> (Value<T>::m_value);}
-		virtual explicit operator MsgPack::uint64    ()const override{return static_cast<MsgPack::uint64> (Value<T>::m_value);}
-		virtual explicit operator MsgPack::int128    ()const override{return static_cast<MsgPack::int128> (Value<T>::m_value);}
-		virtual explicit operator MsgPack::boolean   ()const override{return static_cast<MsgPack::boolean>(Value<T>::m_value);}
-	};
+				out+=key(entry);
+				canonical_msgpack(*entry.value, out, cacheable);
+			}
+		}
+	}
 	
-	template class Number<MsgPack::float32>;
-	template class Number<MsgPack::float64>;
-	template class Number<MsgPack::int8>;
-	template class Number<MsgPack::int16>;
-	template class Number<MsgPack::int32>;
-	template class Number<MsgPack::int64>;
-	template class Number<MsgPack::uint8>;
-	template class Number<MsgPack::uint16>;
-	template class Number<MsgPack::uint32>;
-	template class Number<MsgPack::uint64>;
-	template class Number<MsgPack::boolean>;
+	size_t MsgPack::encoded_size() const
+	{
+		bool cacheable=true;
+		return size_msgpack(*this, cacheable);
+	}
 	
-	template<typename T> requires(std::is_class_v<T>)
-	class Compound final: public Value<T>
+	void MsgPack::dump_to(std::string& out) const
 	{
-	public:
-		virtual operator const T&() const override{return Value<T>::m_value;}
-		Compound(const T& thing):Value<T>(thing){}
-		Compound(T&& thing):Value<T>(thing){}
-		
-		const MsgPack & operator[](size_t i) const override
+		dump_into(*this, out);
+	}
+	
+	void MsgPack::dump_to(binary& out) const
+	{
+		dump_into(*this, out);
+	}
+	
+	std::ostream& operator<<(std::ostream& os, const MsgPack& msgpack)
+	{
+		std::string out;
+		msgpack.dump_to(out);
+		os.write(out.data(), out.size());
+		return os;
+	}
+	
+	void MsgPack::dump_to(std::string& out, Canonical) const
+	{
+		if(m_ptr)
+			m_ptr->dump_canonical_root(out);
+		else
+			dump_into(*this, out);
+	}
+	
+	namespace
+	{
+		// MurmurHash64A, reading words little-endian so that a fingerprint
+		// is the same on every host.
+		uint64_t murmur64(std::string_view bytes)
 		{
-			if constexpr(std::is_same_v<T,MsgPack::array>)
-				return Value<T>::m_value.at(i);
-			else
-				throw TypeError(typeid(MsgPack::array),typeid(T));
+			constexpr uint64_t m=0xc6a4a7935bd1e995ULL;
+			constexpr int r=47;
+			uint64_t h=bytes.size()*m;
+			const uint8_t* p=reinterpret_cast<const uint8_t*>(bytes.data());
+			size_t const words=bytes.size()/8;
+			for(size_t i=0; i<words; ++i, p+=8)
+			{
+				uint64_t k;
+				std::memcpy(&k, p, 8);
+				if constexpr(std::endian::native==std::endian::big)
+					k=byteswap(k);
+				k*=m;
+				k^=k>>r;
+				k*=m;
+				h^=k;
+				h*=m;
+			}
+			size_t const tail=bytes.size()%8;
+			for(size_t i=tail; i>0; --i)
+				h^=uint64_t(p[i-1])<<(8*(i-1));
+			if(tail)
+				h*=m;
+			h^=h>>r;
+			h*=m;
+			h^=h>>r;
+			return h;
 		}
-		MsgPack & operator[](size_t i) override
+	}
+	
+	uint64_t MsgPack::fingerprint() const
+	{
+		return murmur64(dump(Canonical()));
+	}
+	
+	/* * * * * * * * * * * * * * * * * * * *
+ * Packer
+ *
+ * Each call measures what it writes with the encoded_size() overloads,
+ * grows the buffer by that much and writes through a RawWriter, as
+ * dump_to() does for a whole value.
+ */
+	
+	uint8_t* Packer::grow(size_t n)
+	{
+		if(m_string)
 		{
-			if constexpr(std::is_same_v<T,MsgPack::array>)
-				return Value<T>::m_value.at(i);
-			else
-				throw TypeError(typeid(MsgPack::array),typeid(T));
+			size_t const offset=m_string->size();
+			m_string->resize(offset+n);
+			return reinterpret_cast<uint8_t*>(m_string->data())+offset;
 		}
-		
-		MsgPack const &operator[](const MsgPack &key) const override
+		size_t const offset=m_binary->size();
+		m_binary->resize(offset+n);
+		return m_binary->data()+offset;
+	}
+	
+	// Count a value that is complete in the innermost open container, and
+	// carry on outwards through the counted ones it completes.
+	void Packer::completed()
+	{
+		while(!m_open.empty())
+		{
+			Open& top=m_open.back();
+			if(!top.counted)
+			{
+				++top.values;
+				return;
+			}
+			if(--top.values)
+				return;
+			m_open.pop_back();
+		}
+	}
+	
+	template<typename T>
+	Packer& Packer::emit(const T& value)
+	{
+		RawWriter out(grow(encoded_size(value)));
+		dump(value, out);
+		if(!m_open.empty())
+			completed();
+		return *this;
+	}
+	
+	Packer& Packer::pack_nil()                          { return emit(nullptr); }
+	Packer& Packer::pack_bool(bool value)               { return emit(value); }
+	Packer& Packer::pack_int(int64_t value)             { return emit(value); }
+	Packer& Packer::pack_uint(uint64_t value)           { return emit(value); }
+	Packer& Packer::pack_float(float value)             { return emit(value); }
+	Packer& Packer::pack_double(double value)           { return emit(value); }
+	Packer& Packer::pack_str(std::string_view value)    { return emit(value); }
+	Packer& Packer::pack_bin(std::span<const uint8_t> value) { return emit(value); }
+	
+	Packer& Packer::pack_ext(uint8_t type, std::span<const uint8_t> data)
+	{
+		RawWriter out(grow(encoded_extension_size(data.size())));
+		dump_extension(type, data, out);
+		if(!m_open.empty())
+			completed();
+		return *this;
+	}
+	
+	Packer& Packer::begin_array(uint32_t size)
+	{
+		RawWriter out(grow(encoded_header_size(size)));
+		dump_array_header(size, out);
+		if(!m_open.empty())
+		{
+			if(size)
+				m_open.push_back({size, 0, false, true});
+			else
+				completed();
+		}
+		return *this;
+	}
+	
+	Packer& Packer::begin_map(uint32_t size)
+	{
+		RawWriter out(grow(encoded_header_size(size)));
+		dump_map_header(size, out);
+		if(!m_open.empty())
+		{
+			if(size)
+				m_open.push_back({2*uint64_t(size), 0, true, true});
+			else
+				completed();
+		}
+		return *this;
+	}
+	
+	Packer& Packer::begin_array()
+	{
+		m_open.push_back({0, position(), false, false});
+		grow(5);
+		return *this;
+	}
+	
+	Packer& Packer::begin_map()
+	{
+		m_open.push_back({0, position(), true, false});
+		grow(5);
+		return *this;
+	}
+	
+	Packer& Packer::end_array(bool compact) { return end(false, compact); }
+	Packer& Packer::end_map(bool compact)   { return end(true, compact); }
+	
+	Packer& Packer::end(bool is_map, bool compact)
+	{
+		if(m_open.empty() || m_open.back().counted || m_open.back().is_map!=is_map)
+			throw std::runtime_error(is_map ? "end_map() without begin_map()." : "end_array() without begin_array().");
+		Open const closed=m_open.back();
+		if(is_map && closed.values%2)
+			throw std::runtime_error("map key without a value.");
+		uint64_t const count=is_map ? closed.values/2 : closed.values;
+		if(count > 0xffffffff)
+			throw std::runtime_error("exceeded maximum data length");
+		m_open.pop_back();
+		
+		uint8_t* const data=m_string ? reinterpret_cast<uint8_t*>(m_string->data()) : m_binary->data();
+		size_t const size=position();
+		size_t const header=compact ? encoded_header_size(count) : 5;
+		if(header<5)
+		{
+			std::memmove(data+closed.offset+header, data+closed.offset+5, size-closed.offset-5);
+			if(m_string)
+				m_string->resize(size-5+header);
+			else
+				m_binary->resize(size-5+header);
+		}
+		
+		RawWriter out(data+closed.offset);
+		if(header<5 && is_map)
+			dump_map_header(count, out);
+		else if(header<5)
+			dump_array_header(count, out);
+		else
+			dump_header(is_map ? 0xdf : 0xdd, static_cast<uint32_t>(count), out);
+		completed();
+		return *this;
+	}
+	
+	Packer& Packer::pack(const MsgPack& value)
+	{
+		if(m_string)
+			dump_into(value, *m_string);
+		else
+			dump_into(value, *m_binary);
+		if(!m_open.empty())
+			completed();
+		return *this;
+	}
+	
+#ifndef _WIN32
+	/* * * * * * * * * * * * * * * * * * * *
+ * GatherDump
+ *
+ * Walks the value down to the subtrees and payloads that are at least
+ * min_reference bytes. Everything else goes through dump_into() into the
+ * scratch buffer. Pieces of scratch are kept as offsets until the end,
+ * since the buffer moves as it grows.
+ */
+	
+	GatherDump::GatherDump(const MsgPack& value, size_t min_reference):m_value(value)
+	{
+		std::vector<Piece> pieces;
+		append(m_value, min_reference, pieces);
+		m_iov.reserve(pieces.size());
+		for(const Piece& piece:pieces)
+		{
+			const void* const base=piece.data ? piece.data : m_scratch.data()+piece.offset;
+			m_iov.push_back(iovec{const_cast<void*>(base), piece.size});
+			m_size+=piece.size;
+		}
+	}
+	
+	// Append n bytes of scratch, extending the last piece if it is scratch
+	// too, and return where they start.
+	uint8_t* GatherDump::grow(size_t n, std::vector<Piece>& pieces)
+	{
+		size_t const offset=m_scratch.size();
+		m_scratch.resize(offset+n);
+		if(!pieces.empty() && !pieces.back().data)
+			pieces.back().size+=n;
+		else
+			pieces.push_back({nullptr, offset, n});
+		return m_scratch.data()+offset;
+	}
+	
+	void GatherDump::append(const void* data, size_t size, size_t min_reference, std::vector<Piece>& pieces)
+	{
+		if(size < min_reference)
+			std::memcpy(grow(size, pieces), data, size);
+		else if(size)
+			pieces.push_back({data, 0, size});
+	}
+	
+	void GatherDump::append(const MsgPack& value, size_t min_reference, std::vector<Piece>& pieces)
+	{
+		size_t const size=value.encoded_size();
+		switch(size < min_reference ? MsgPack::Type::NUL : value.type())
+		{
+			case MsgPack::Type::ARRAY:
+			{
+				const MsgPack::array& items=value.as<MsgPack::array>();
+				RawWriter out(grow(encoded_header_size(items.size()), pieces));
+				dump_array_header(items.size(), out);
+				for(const auto& item:items)
+					append(item, min_reference, pieces);
+				break;
+			}
+			case MsgPack::Type::OBJECT:
+			{
+				const MsgPack::object& items=value.as<MsgPack::object>();
+				RawWriter out(grow(encoded_header_size(items.size()), pieces));
+				dump_map_header(items.size(), out);
+				for(const auto& item:items)
+				{
+					append(item.first, min_reference, pieces);
+					append(item.second, min_reference, pieces);
+				}
+				break;
+			}
+			case MsgPack::Type::STRING:
+			{
+				std::string_view const text=value.as<std::string_view>();
+				RawWriter out(grow(size-text.size(), pieces));
+				dump_str_header(text.size(), out);
+				append(text.data(), text.size(), min_reference, pieces);
+				break;
+			}
+			case MsgPack::Type::BINARY:
+			{
+				std::span<const uint8_t> const bytes=value.as<std::span<const uint8_t>>();
+				RawWriter out(grow(size-bytes.size(), pieces));
+				dump_bin_header(bytes.size(), out);
+				append(bytes.data(), bytes.size(), min_reference, pieces);
+				break;
+			}
+			case MsgPack::Type::EXTENSION:
+			{
+				const MsgPack::extension& extension=value.as<MsgPack::extension>();
+				const MsgPack::binary& data=std::get<1>(extension);
+				RawWriter out(grow(size-data.size(), pieces));
+				dump_ext_header(std::get<0>(extension), data.size(), out);
+				append(data.data(), data.size(), min_reference, pieces);
+				break;
+			}
+			default:
+			{
+				RawWriter out(grow(size, pieces));
+				dump_msgpack(value, out);
+				break;
+			}
+		}
+	}
+#endif
+	
+	/* * * * * * * * * * * * * * * * * * * *
+ * Value wrappers
+ */
+	
+	namespace
+	{
+		/* CanonicalCache
+     *
+     * The canonical encoding of the array or object dump(Canonical) was
+     * last called on, kept on the same terms as a cached encoded size: for
+     * the epoch it was made in, and only if nothing in it had handed out
+     * a mutable reference. The containers below encode afresh and keep
+     * nothing.
+     */
+		class CanonicalCache
+		{
+		public:
+			void dump(const MsgPackValue& owner, std::string& out) const
+			{
+				uint64_t const epoch=size_epoch.load(std::memory_order_acquire);
+				std::shared_ptr<const Bytes> cached=m_bytes.load(std::memory_order_acquire);
+				if(!cached || cached->epoch!=epoch)
+				{
+					auto bytes=std::make_shared<Bytes>(epoch);
+					bool cacheable=true;
+					owner.dump_canonical(bytes->bytes, cacheable);
+					if(!cacheable)
+					{
+						out+=bytes->bytes;
+						return;
+					}
+					m_bytes.store(bytes, std::memory_order_release);
+					cached=std::move(bytes);
+				}
+				out+=cached->bytes;
+			}
+			
+			void clear() const
+			{
+				m_bytes.store(nullptr, std::memory_order_release);
+			}
+			
+		private:
+			struct Bytes
+			{
+				explicit Bytes(uint64_t epoch):epoch(epoch){}
+				uint64_t epoch;
+				std::string bytes;
+			};
+			
+			mutable std::atomic<std::shared_ptr<const Bytes>> m_bytes;
+		};
+		
+		struct NoCanonicalCache {};
+	}
+	
+	template <typename T>
+	class Value : public MsgPackValue
+	{
+	public:
+		// Constructors
+		Value(const T& value):MsgPackValue(type_of<T>),m_value(value){}
+		Value(T&& value):MsgPackValue(type_of<T>),m_value(std::move(value)){}
+		~Value()
+		{
+			unlink_members();
+		}
+		// Comparisons; MsgPack only compares values of the same type. Both
+		// sides are read through the accessors, which Lazy and Borrowed
+		// nodes override; strings and binaries are compared in place.
+		virtual bool operator==(const MsgPackValue &other) const override
+		{
+			if constexpr(std::is_same_v<T,MsgPack::string>)
+				return static_cast<std::string_view>(*this)==static_cast<std::string_view>(other);
+			else if constexpr(std::is_same_v<T,MsgPack::binary>)
+			{
+				auto const lhs=static_cast<std::span<const uint8_t>>(*this);
+				auto const rhs=static_cast<std::span<const uint8_t>>(other);
+				return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+			}
+			else
+				return static_cast<const T&>(*this)==static_cast<const T&>(other);
+		}
+		virtual std::partial_ordering operator<=>(const MsgPackValue &other) const override
+		{
+			if constexpr(std::is_same_v<T,MsgPack::string>)
+				return static_cast<std::string_view>(*this)<=>static_cast<std::string_view>(other);
+			else if constexpr(std::is_same_v<T,MsgPack::binary>)
+			{
+				auto const lhs=static_cast<std::span<const uint8_t>>(*this);
+				auto const rhs=static_cast<std::span<const uint8_t>>(other);
+				return std::lexicographical_compare_three_way(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+			}
+			else
+				return static_cast<const T&>(*this)<=>static_cast<const T&>(other);
+		}
+		T m_value;
+		virtual size_t encoded_size(bool& cacheable) const override
+		{
+			if constexpr(std::is_same_v<T,MsgPack::array>||std::is_same_v<T,MsgPack::object>)
+			{
+				return cached_size(cacheable, [this](bool& subtree){ return msgpack11::encoded_size(m_value, subtree, subtree ? this : nullptr); });
+			}
+			else
+			{
+				if(mutated())
+					cacheable=false;
+				return msgpack11::encoded_size(m_value);
+			}
+		}
+		virtual void dump(RawWriter& out) const override { msgpack11::dump(m_value, out); }
+		// Read through the accessors, like the comparisons, so that Lazy
+		// and Borrowed nodes are encoded afresh rather than copied.
+		virtual void dump_canonical(std::string& out, bool& cacheable) const override
+		{
+			if constexpr(std::is_same_v<T,MsgPack::object>)
+				canonical_map(static_cast<const T&>(*this), mutated() ? nullptr : this, out, cacheable);
+			else if constexpr(std::is_same_v<T,MsgPack::array>)
+			{
+				const T& items=static_cast<const T&>(*this);
+				size_t const offset=out.size();
+				out.resize(offset+encoded_header_size(items.size()));
+				RawWriter header(reinterpret_cast<uint8_t*>(out.data())+offset);
+				dump_array_header(items.size(), header);
+				// Changes below must reach a cache above through this array.
+				const MsgPackValue* parent=mutated() ? nullptr : this;
+				for(const auto& item:items)
+				{
+					link_member(item, parent);
+					canonical_msgpack(item, out, cacheable);
+				}
+			}
+			else if constexpr(std::is_same_v<T,MsgPack::string>)
+				append_encoded(static_cast<std::string_view>(*this), out);
+			else if constexpr(std::is_same_v<T,MsgPack::binary>)
+				append_encoded(static_cast<std::span<const uint8_t>>(*this), out);
+			else
+				append_encoded(static_cast<const T&>(*this), out);
+			if(mutated())
+				cacheable=false;
+		}
+		// Arrays and objects outside a Document keep what they encode.
+		virtual void dump_canonical_root(std::string& out) const override
+		{
+			if constexpr(is_container)
+			{
+				if(!in_arena())
+				{
+					m_canonical.dump(*this, out);
+					return;
+				}
+			}
+			MsgPackValue::dump_canonical_root(out);
+		}
+		virtual explicit operator T&(){return m_value;}
+		
+		// Point the members of an array or object at it. The sizing and
+		// canonical walks do this on the way; Lazy does it for members it
+		// decodes after a container may have counted it.
+		void link_members() const
+		{
+			for_each_member([this](const MsgPackValue& member){ member.link(this); });
+		}
+		
+	protected:
+		void forget() const override
+		{
+			MsgPackValue::forget();
+			if constexpr(is_container)
+				m_canonical.clear();
+		}
+		void unlink_members() const override
+		{
+			for_each_member([this](const MsgPackValue& member){ member.unlink(this); });
+		}
+		
+	private:
+		template<typename F>
+		void for_each_member(F&& visitor) const
+		{
+			auto const visit=[&visitor](const MsgPack& member)
+			{
+				if(const MsgPackValue* value=value_of(member))
+					visitor(*value);
+			};
+			if constexpr(std::is_same_v<T,MsgPack::array>)
+			{
+				for(const auto& item:m_value)
+					visit(item);
+			}
+			else if constexpr(std::is_same_v<T,MsgPack::object>)
+			{
+				for(const auto& item:m_value)
+				{
+					visit(item.first);
+					visit(item.second);
+				}
+			}
+		}
+		
+		static constexpr bool is_container=std::is_same_v<T,MsgPack::array>||std::is_same_v<T,MsgPack::object>;
+		[[no_unique_address]] std::conditional_t<is_container,CanonicalCache,NoCanonicalCache> m_canonical;
+	};
+	
+	template<typename T> requires(std::is_class_v<T>)
+	class Compound final: public Value<T>
+	{
+	public:
+		virtual operator const T&() const override{return Value<T>::m_value;}
+		Compound(const T& thing):Value<T>(thing){}
+		Compound(T&& thing):Value<T>(std::move(thing)){}
+		
+		explicit operator std::string_view() const override
+		{
+			if constexpr(std::is_same_v<T,MsgPack::string>)
+				return Value<T>::m_value;
+			else
+				throw TypeError(MsgPack::Type::STRING,type_of<T>);
+		}
+		explicit operator std::span<const uint8_t>() const override
+		{
+			if constexpr(std::is_same_v<T,MsgPack::binary>)
+				return Value<T>::m_value;
+			else
+				throw TypeError(MsgPack::Type::BINARY,type_of<T>);
+		}
+		
+		const MsgPack & operator[](size_t i) const override
+		{
+			if constexpr(std::is_same_v<T,MsgPack::array>)
+				return Value<T>::m_value.at(i);
+			else
+				throw TypeError(MsgPack::Type::ARRAY,type_of<T>);
+		}
+		MsgPack & operator[](size_t i) override
+		{
+			if constexpr(std::is_same_v<T,MsgPack::array>)
+				return Value<T>::m_value.at(i);
+			else
+				throw TypeError(MsgPack::Type::ARRAY,type_of<T>);
+		}
+		
+		MsgPack const &operator[](const MsgPack &key) const override
 		{
 			if constexpr(std::is_same_v<T,MsgPack::object>)
 				return Value<T>::m_value.at(key);
 			else
-				throw TypeError(typeid(MsgPack::object),typeid(T));
+				throw TypeError(MsgPack::Type::OBJECT,type_of<T>);
 		}
 		MsgPack& operator[](const MsgPack &key) override
 		{
 			if constexpr(std::is_same_v<T,MsgPack::object>)
 				return Value<T>::m_value[key];
 			else
-				throw TypeError(typeid(MsgPack::object),typeid(T));
+				throw TypeError(MsgPack::Type::OBJECT,type_of<T>);
 		}
 	};
 	template class Compound<MsgPack::string>;
@@ -585,38 +1509,98 @@ namespace msgpack11
 	template class Compound<MsgPack::object>;
 	template class Compound<MsgPack::extension>;
 	
-	template class Value<reverSilly::none>;
-	
-	MsgPack::Type MsgPackValue::type()const
-	{
-		static const std::unordered_map<std::type_index,MsgPack::Type>table
-		{
-			{typeid(Number<MsgPack::float32>),MsgPack::Type::FLOAT32},
-			{typeid(Number<MsgPack::float64>),MsgPack::Type::FLOAT64},
-			{typeid(Number<MsgPack::int8>),MsgPack::Type::INT8},
-			{typeid(Number<MsgPack::int16>),MsgPack::Type::INT16},
-			{typeid(Number<MsgPack::int32>),MsgPack::Type::INT32},
-			{typeid(Number<MsgPack::int64>),MsgPack::Type::INT64},
-			{typeid(Number<MsgPack::uint8>),MsgPack::Type::UINT8},
-			{typeid(Number<MsgPack::uint16>),MsgPack::Type::UINT16},
-			{typeid(Number<MsgPack::uint32>),MsgPack::Type::UINT32},
-			{typeid(Number<MsgPack::uint64>),MsgPack::Type::UINT64},
-			{typeid(Number<MsgPack::boolean>),MsgPack::Type::BOOL},
-			{typeid(Compound<MsgPack::array>),MsgPack::Type::ARRAY},
-			{typeid(Compound<MsgPack::extension>),MsgPack::Type::EXTENSION},
-			{typeid(Compound<MsgPack::object>),MsgPack::Type::OBJECT},
-			{typeid(Compound<MsgPack::binary>),MsgPack::Type::BINARY},
-			{typeid(Compound<MsgPack::string>),MsgPack::Type::STRING},
-			{typeid(Value<reverSilly::none>),MsgPack::Type::NUL}
-		};
-		return table.at(typeid(*this));
+	/* Borrowed<T>
+     *
+     * A string or binary from MsgPack::parse_borrowed(), pointing into the
+     * input rather than holding a copy of it; owner, if any, keeps the
+     * input alive. The copy is made the first time a std::string or binary
+     * reference is asked for, and from then on stands in for the input.
+     */
+	template<typename T>
+	class Borrowed final: public Value<T>
+	{
+	public:
+		using View=std::conditional_t<std::is_same_v<T,MsgPack::string>,std::string_view,std::span<const uint8_t>>;
+		
+		Borrowed(View bytes, std::shared_ptr<const void> owner):
+			Value<T>(T()),m_bytes(bytes),m_owner(std::move(owner)){}
+		
+		operator const T&() const override
+		{
+			copy();
+			return Value<T>::m_value;
+		}
+		operator T&() override
+		{
+			copy();
+			return Value<T>::m_value;
+		}
+		
+		explicit operator std::string_view() const override
+		{
+			if constexpr(std::is_same_v<T,MsgPack::string>)
+				return view();
+			else
+				throw TypeError(MsgPack::Type::STRING,type_of<T>);
+		}
+		explicit operator std::span<const uint8_t>() const override
+		{
+			if constexpr(std::is_same_v<T,MsgPack::binary>)
+				return view();
+			else
+				throw TypeError(MsgPack::Type::BINARY,type_of<T>);
+		}
+		
+		size_t encoded_size(bool& cacheable) const override
+		{
+			if(this->mutated())
+				cacheable=false;
+			return msgpack11::encoded_size(view());
+		}
+		void dump(RawWriter& out) const override { msgpack11::dump(view(), out); }
+		
+	private:
+		View view() const
+		{
+			if(m_copied.load(std::memory_order_acquire))
+				return View(Value<T>::m_value);
+			return m_bytes;
+		}
+		
+		void copy() const
+		{
+			std::call_once(m_once, [this]
+			{
+				const_cast<T&>(Value<T>::m_value).assign(m_bytes.begin(), m_bytes.end());
+				m_copied.store(true, std::memory_order_release);
+			});
+		}
+		
+		View m_bytes;
+		std::shared_ptr<const void> m_owner;
+		mutable std::once_flag m_once;
+		mutable std::atomic<bool> m_copied{false};
+	};
+	
+	const MsgPackValue* value_of(const MsgPack& msgpack)
+	{
+		return msgpack.m_ptr.get();
+	}
+	
+	MsgPack adopt_msgpack(std::shared_ptr<MsgPackValue> node)
+	{
+		MsgPack ret;
+		ret.m_type=node->type();
+		ret.m_ptr=std::move(node);
+		return ret;
 	}
+	
 	/* * * * * * * * * * * * * * * * * * * *
  * Constructors
  */
 	
-	MsgPack::MsgPack()                                 : m_ptr(std::make_shared<Value<reverSilly::none>>()){}
-	MsgPack::MsgPack(std::nullptr_t)                   : m_ptr(std::make_shared<Value<reverSilly::none>>()){}
+	MsgPack::MsgPack()                                 : m_type(Type::NUL), m_uint64(0) {}
+	MsgPack::MsgPack(std::nullptr_t)                   : m_type(Type::NUL), m_uint64(0) {}
 //	
 //	template<typename T> requires(std::is_fundamental_v<T>)
 //	MsgPack::MsgPack(T value):m_ptr(std::make_shared<Number<T>>(value)){}
@@ -649,41 +1633,90 @@ namespace msgpack11
 //	template MsgPack::MsgPack(MsgPack::string&&);
 //	template MsgPack::MsgPack(MsgPack::string const&);
 
-	MsgPack::MsgPack(MsgPack::float32 value)           : m_ptr(std::make_shared<Number<MsgPack::float32>>(value)) {}
-	MsgPack::MsgPack(MsgPack::float64 value)           : m_ptr(std::make_shared<Number<MsgPack::float64>>(value)) {}
-	MsgPack::MsgPack(MsgPack::int8 value)              : m_ptr(std::make_shared<Number<MsgPack::int8>>(value)) {}
-	MsgPack::MsgPack(MsgPack::int16 value)             : m_ptr(std::make_shared<Number<MsgPack::int16>>(value)) {}
-	MsgPack::MsgPack(MsgPack::int32 value)             : m_ptr(std::make_shared<Number<MsgPack::int32>>(value)) {}
-	MsgPack::MsgPack(MsgPack::int64 value)             : m_ptr(std::make_shared<Number<MsgPack::int64>>(value)) {}
-	MsgPack::MsgPack(MsgPack::uint8 value)             : m_ptr(std::make_shared<Number<MsgPack::uint8>>(value)) {}
-	MsgPack::MsgPack(MsgPack::uint16 value)            : m_ptr(std::make_shared<Number<MsgPack::uint16>>(value)) {}
-	MsgPack::MsgPack(MsgPack::uint32 value)            : m_ptr(std::make_shared<Number<MsgPack::uint32>>(value)) {}
-	MsgPack::MsgPack(MsgPack::uint64 value)            : m_ptr(std::make_shared<Number<MsgPack::uint64>>(value)) {}
-	MsgPack::MsgPack(MsgPack::boolean value)           : m_ptr(std::make_shared<Number<MsgPack::boolean>>(value)) {}
-	MsgPack::MsgPack(const MsgPack::string &value)     : m_ptr(std::make_shared<Compound<MsgPack::string>>(value)) {}
-	MsgPack::MsgPack(MsgPack::string &&value)          : m_ptr(std::make_shared<Compound<MsgPack::string>>(move(value))) {}
-	MsgPack::MsgPack(const MsgPack::array &values)     : m_ptr(std::make_shared<Compound<MsgPack::array>>(values)) {}
-	MsgPack::MsgPack(MsgPack::array &&values)          : m_ptr(std::make_shared<Compound<MsgPack::array>>(move(values))) {}
-	MsgPack::MsgPack(const MsgPack::object &values)    : m_ptr(std::make_shared<Compound<MsgPack::object>>(values)) {}
-	MsgPack::MsgPack(MsgPack::object &&values)         : m_ptr(std::make_shared<Compound<MsgPack::object>>(move(values))) {}
-	MsgPack::MsgPack(const MsgPack::binary &values)    : m_ptr(std::make_shared<Compound<MsgPack::binary>>(values)) {}
-	MsgPack::MsgPack(MsgPack::binary &&values)         : m_ptr(std::make_shared<Compound<MsgPack::binary>>(move(values))) {}
-	MsgPack::MsgPack(const MsgPack::extension &values) : m_ptr(std::make_shared<Compound<MsgPack::extension>>(values)) {}
-	MsgPack::MsgPack(MsgPack::extension &&values)      : m_ptr(std::make_shared<Compound<MsgPack::extension>>(move(values))) {}
+	MsgPack::MsgPack(MsgPack::float32 value)           : m_type(Type::FLOAT32), m_float32(value) {}
+	MsgPack::MsgPack(MsgPack::float64 value)           : m_type(Type::FLOAT64), m_float64(value) {}
+	MsgPack::MsgPack(MsgPack::int8 value)              : m_type(Type::INT8),    m_int8(value) {}
+	MsgPack::MsgPack(MsgPack::int16 value)             : m_type(Type::INT16),   m_int16(value) {}
+	MsgPack::MsgPack(MsgPack::int32 value)             : m_type(Type::INT32),   m_int32(value) {}
+	MsgPack::MsgPack(MsgPack::int64 value)             : m_type(Type::INT64),   m_int64(value) {}
+	MsgPack::MsgPack(MsgPack::uint8 value)             : m_type(Type::UINT8),   m_uint8(value) {}
+	MsgPack::MsgPack(MsgPack::uint16 value)            : m_type(Type::UINT16),  m_uint16(value) {}
+	MsgPack::MsgPack(MsgPack::uint32 value)            : m_type(Type::UINT32),  m_uint32(value) {}
+	MsgPack::MsgPack(MsgPack::uint64 value)            : m_type(Type::UINT64),  m_uint64(value) {}
+	MsgPack::MsgPack(MsgPack::boolean value)           : m_type(Type::BOOL),    m_boolean(value) {}
+	MsgPack::MsgPack(const MsgPack::string &value)     : m_type(Type::STRING),    m_uint64(0), m_ptr(std::make_shared<Compound<MsgPack::string>>(value)) {}
+	MsgPack::MsgPack(const char * value)               : m_type(Type::STRING),    m_uint64(0), m_ptr(std::make_shared<Compound<MsgPack::string>>(value)) {}
+	MsgPack::MsgPack(MsgPack::string &&value)          : m_type(Type::STRING),    m_uint64(0), m_ptr(std::make_shared<Compound<MsgPack::string>>(move(value))) {}
+	MsgPack::MsgPack(const MsgPack::array &values)     : m_type(Type::ARRAY),     m_uint64(0), m_ptr(std::make_shared<Compound<MsgPack::array>>(values)) {}
+	MsgPack::MsgPack(MsgPack::array &&values)          : m_type(Type::ARRAY),     m_uint64(0), m_ptr(std::make_shared<Compound<MsgPack::array>>(move(values))) {}
+	MsgPack::MsgPack(const MsgPack::object &values)    : m_type(Type::OBJECT),    m_uint64(0), m_ptr(std::make_shared<Compound<MsgPack::object>>(values)) {}
+	MsgPack::MsgPack(MsgPack::object &&values)         : m_type(Type::OBJECT),    m_uint64(0), m_ptr(std::make_shared<Compound<MsgPack::object>>(move(values))) {}
+	MsgPack::MsgPack(const MsgPack::binary &values)    : m_type(Type::BINARY),    m_uint64(0), m_ptr(std::make_shared<Compound<MsgPack::binary>>(values)) {}
+	MsgPack::MsgPack(MsgPack::binary &&values)         : m_type(Type::BINARY),    m_uint64(0), m_ptr(std::make_shared<Compound<MsgPack::binary>>(move(values))) {}
+	MsgPack::MsgPack(const MsgPack::extension &values) : m_type(Type::EXTENSION), m_uint64(0), m_ptr(std::make_shared<Compound<MsgPack::extension>>(values)) {}
+	MsgPack::MsgPack(MsgPack::extension &&values)      : m_type(Type::EXTENSION), m_uint64(0), m_ptr(std::make_shared<Compound<MsgPack::extension>>(move(values))) {}
 	
 	/* * * * * * * * * * * * * * * * * * * *
  * Accessors
  */
 	
-	MsgPack::Type MsgPack::type() const{ return m_ptr->type(); }
 	//immutable type specify
-	template<typename T> requires(std::is_fundamental_v<T>)
-	MsgPack::operator T() const{return m_ptr->operator T();}
-	template<typename T> requires(!std::is_fundamental_v<T>)
-	MsgPack::operator const T&() const{return m_ptr->operator const T&();}
+	template<typename T> requires(scalar_type<T>||view_type<T>)
+	MsgPack::operator T() const
+	{
+		if constexpr(view_type<T>)
+		{
+			if(!m_ptr)
+				throw TypeError(type_of<T>,m_type);
+			return static_cast<T>(*m_ptr);
+		}
+		else
+		{
+			return visit_scalar([this](auto value)->T
+			{
+				if constexpr(std::is_same_v<decltype(value),std::nullptr_t>)
+					throw TypeError(type_of<T>,m_type);
+				else
+					return static_cast<T>(value);
+			});
+		}
+	}
+	template<typename T> requires(!scalar_type<T>&&!view_type<T>)
+	MsgPack::operator const T&() const
+	{
+		if(!m_ptr)
+			throw TypeError(type_of<T>,m_type);
+		return m_ptr->operator const T&();
+	}
 	//mutable ones
-	template<typename T> requires(!std::is_const_v<T>)
-	MsgPack::operator T&(){return m_ptr->operator T&();}
+	template<typename T> requires(!std::is_const_v<T>&&!view_type<T>)
+	MsgPack::operator T&()
+	{
+		if constexpr(scalar_type<T>)
+		{
+			if(m_type!=type_of<T>)
+				throw TypeError(type_of<T>,m_type);
+			if constexpr(std::is_same_v<T,float32>)      return m_float32;
+			else if constexpr(std::is_same_v<T,float64>) return m_float64;
+			else if constexpr(std::is_same_v<T,int8>)    return m_int8;
+			else if constexpr(std::is_same_v<T,int16>)   return m_int16;
+			else if constexpr(std::is_same_v<T,int32>)   return m_int32;
+			else if constexpr(std::is_same_v<T,int64>)   return m_int64;
+			else if constexpr(std::is_same_v<T,uint8>)   return m_uint8;
+			else if constexpr(std::is_same_v<T,uint16>)  return m_uint16;
+			else if constexpr(std::is_same_v<T,uint32>)  return m_uint32;
+			else if constexpr(std::is_same_v<T,uint64>)  return m_uint64;
+			else if constexpr(std::is_same_v<T,boolean>) return m_boolean;
+			else throw TypeError(type_of<T>,m_type);
+		}
+		else
+		{
+			if(!m_ptr)
+				throw TypeError(type_of<T>,m_type);
+			m_ptr->mark_mutated();
+			return m_ptr->operator T&();
+		}
+	}
 	
 	template MsgPack::operator MsgPack::int8() const;
 	template MsgPack::operator MsgPack::int16() const;
@@ -697,6 +1730,8 @@ namespace msgpack11
 	template MsgPack::operator MsgPack::float32() const;
 	template MsgPack::operator MsgPack::float64() const;
 	template MsgPack::operator MsgPack::boolean() const;
+	template MsgPack::operator std::string_view() const;
+	template MsgPack::operator std::span<const uint8_t>() const;
 	template MsgPack::operator const MsgPack::string&() const;
 	template MsgPack::operator const MsgPack::array&() const;
 	template MsgPack::operator const MsgPack::object&() const;
@@ -721,61 +1756,137 @@ namespace msgpack11
 	template MsgPack::operator MsgPack::binary&();
 	template MsgPack::operator MsgPack::extension&();
 	
-	const MsgPack &MsgPack::operator[] (size_t i)                     const { return m_ptr->operator[](i); }
-	MsgPack &MsgPack::operator[] (size_t i)                                 { return m_ptr->operator[](i); }
-	const MsgPack &MsgPack::operator[] (const MsgPack &key)           const { return m_ptr->operator[](key); }
-	MsgPack &MsgPack::operator[] (const MsgPack &key)                       { return m_ptr->operator[](key); }
+	const MsgPack &MsgPack::operator[] (size_t i) const
+	{
+		if(!m_ptr)
+			throw TypeError(Type::ARRAY,m_type);
+		return m_ptr->operator[](i);
+	}
+	MsgPack &MsgPack::operator[] (size_t i)
+	{
+		if(!m_ptr)
+			throw TypeError(Type::ARRAY,m_type);
+		m_ptr->mark_mutated();
+		return m_ptr->operator[](i);
+	}
+	const MsgPack &MsgPack::operator[] (const MsgPack &key) const
+	{
+		if(!m_ptr)
+			throw TypeError(Type::OBJECT,m_type);
+		return m_ptr->operator[](key);
+	}
+	MsgPack &MsgPack::operator[] (const MsgPack &key)
+	{
+		if(!m_ptr)
+			throw TypeError(Type::OBJECT,m_type);
+		m_ptr->mark_mutated();
+		return m_ptr->operator[](key);
+	}
 	
 	//immutable
-	MsgPackValue::operator MsgPack::float32             ()   const { throw TypeError(typeid(Number<MsgPack::float32>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::float64             ()   const { throw TypeError(typeid(Number<MsgPack::float64>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::int128              ()   const { throw TypeError(typeid(Number<MsgPack::int128>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::int8                ()   const { throw TypeError(typeid(Number<MsgPack::int8>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::int16               ()   const { throw TypeError(typeid(Number<MsgPack::int16>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::int32               ()   const { throw TypeError(typeid(Number<MsgPack::int32>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::int64               ()   const { throw TypeError(typeid(Number<MsgPack::int64>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::uint8               ()   const { throw TypeError(typeid(Number<MsgPack::uint8>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::uint16              ()   const { throw TypeError(typeid(Number<MsgPack::uint16>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::uint32              ()   const { throw TypeError(typeid(Number<MsgPack::uint32>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::uint64              ()   const { throw TypeError(typeid(Number<MsgPack::uint64>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::boolean             ()   const { throw TypeError(typeid(Number<MsgPack::boolean>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::string       const &()   const { throw TypeError(typeid(Compound<MsgPack::string>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::array        const &()   const { throw TypeError(typeid(Compound<MsgPack::array>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::object       const &()   const { throw TypeError(typeid(Compound<MsgPack::object>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::binary       const &()   const { throw TypeError(typeid(Compound<MsgPack::binary>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::extension    const &()   const { throw TypeError(typeid(Compound<MsgPack::extension>),typeid(*this)); }
+	MsgPackValue::operator MsgPack::string       const &()   const { throw TypeError(MsgPack::Type::STRING,type()); }
+	MsgPackValue::operator MsgPack::array        const &()   const { throw TypeError(MsgPack::Type::ARRAY,type()); }
+	MsgPackValue::operator MsgPack::object       const &()   const { throw TypeError(MsgPack::Type::OBJECT,type()); }
+	MsgPackValue::operator MsgPack::binary       const &()   const { throw TypeError(MsgPack::Type::BINARY,type()); }
+	MsgPackValue::operator MsgPack::extension    const &()   const { throw TypeError(MsgPack::Type::EXTENSION,type()); }
+	MsgPackValue::operator std::string_view             ()   const { throw TypeError(MsgPack::Type::STRING,type()); }
+	MsgPackValue::operator std::span<const uint8_t>     ()   const { throw TypeError(MsgPack::Type::BINARY,type()); }
 	//mutable
-	MsgPackValue::operator MsgPack::float32  &()         { throw TypeError(typeid(Number<MsgPack::float32>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::float64  &()         { throw TypeError(typeid(Number<MsgPack::float64>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::int128   &()         { throw TypeError(typeid(Number<MsgPack::int128>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::int8     &()         { throw TypeError(typeid(Number<MsgPack::int8>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::int16    &()         { throw TypeError(typeid(Number<MsgPack::int16>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::int32    &()         { throw TypeError(typeid(Number<MsgPack::int32>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::int64    &()         { throw TypeError(typeid(Number<MsgPack::int64>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::uint8    &()         { throw TypeError(typeid(Number<MsgPack::uint8>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::uint16   &()         { throw TypeError(typeid(Number<MsgPack::uint16>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::uint32   &()         { throw TypeError(typeid(Number<MsgPack::uint32>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::uint64   &()         { throw TypeError(typeid(Number<MsgPack::uint64>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::boolean  &()         { throw TypeError(typeid(Number<MsgPack::boolean>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::string   &()         { throw TypeError(typeid(Compound<MsgPack::string>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::array    &()         { throw TypeError(typeid(Compound<MsgPack::array>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::object   &()         { throw TypeError(typeid(Compound<MsgPack::object>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::binary   &()         { throw TypeError(typeid(Compound<MsgPack::binary>),typeid(*this)); }
-	MsgPackValue::operator MsgPack::extension&()         { throw TypeError(typeid(Compound<MsgPack::extension>),typeid(*this)); }
+	MsgPackValue::operator MsgPack::string   &()         { throw TypeError(MsgPack::Type::STRING,type()); }
+	MsgPackValue::operator MsgPack::array    &()         { throw TypeError(MsgPack::Type::ARRAY,type()); }
+	MsgPackValue::operator MsgPack::object   &()         { throw TypeError(MsgPack::Type::OBJECT,type()); }
+	MsgPackValue::operator MsgPack::binary   &()         { throw TypeError(MsgPack::Type::BINARY,type()); }
+	MsgPackValue::operator MsgPack::extension&()         { throw TypeError(MsgPack::Type::EXTENSION,type()); }
 	//access
-	const MsgPack &MsgPackValue::operator[](size_t)         const { throw TypeError(typeid(Compound<MsgPack::array>),typeid(*this)); }
-	MsgPack       &MsgPackValue::operator[](size_t)               { throw TypeError(typeid(Compound<MsgPack::array>),typeid(*this)); }
-	const MsgPack &MsgPackValue::operator[](const MsgPack&) const { throw TypeError(typeid(Compound<MsgPack::object>),typeid(*this)); }
-	MsgPack       &MsgPackValue::operator[](const MsgPack&)       { throw TypeError(typeid(Compound<MsgPack::object>),typeid(*this)); }
+	const MsgPack &MsgPackValue::operator[](size_t)         const { throw TypeError(MsgPack::Type::ARRAY,type()); }
+	MsgPack       &MsgPackValue::operator[](size_t)               { throw TypeError(MsgPack::Type::ARRAY,type()); }
+	const MsgPack &MsgPackValue::operator[](const MsgPack&) const { throw TypeError(MsgPack::Type::OBJECT,type()); }
+	MsgPack       &MsgPackValue::operator[](const MsgPack&)       { throw TypeError(MsgPack::Type::OBJECT,type()); }
 	
 	/* * * * * * * * * * * * * * * * * * * *
  * Comparison
  */
 	
-	bool MsgPack::operator==(const MsgPack &other) const{return *m_ptr==*other.m_ptr;}
-	
-	std::partial_ordering MsgPack::operator<=> (const MsgPack &other) const{return *m_ptr<=>*other.m_ptr;}
-	
+	// Numbers compare by value across their storage types: two ints are
+	// compared exactly, anything involving a float is compared as float64.
+	bool MsgPack::operator==(const MsgPack &other) const
+	{
+		if(is_number()&&other.is_number())
+		{
+			if(is_int()&&other.is_int())
+				return operator int128()==other.operator int128();
+			return operator float64()==other.operator float64();
+		}
+		if(m_type!=other.m_type)
+			return false;
+		if(m_ptr)
+			return m_ptr==other.m_ptr||*m_ptr==*other.m_ptr;
+		return m_type!=Type::BOOL||m_boolean==other.m_boolean;
+	}
+	
+	std::partial_ordering MsgPack::operator<=> (const MsgPack &other) const
+	{
+		if(is_number()&&other.is_number())
+		{
+			if(is_int()&&other.is_int())
+				return operator int128()<=>other.operator int128();
+			return operator float64()<=>other.operator float64();
+		}
+		if(m_type!=other.m_type)
+			return m_type<=>other.m_type;
+		if(m_ptr)
+			return *m_ptr<=>*other.m_ptr;
+		if(m_type==Type::BOOL)
+			return m_boolean<=>other.m_boolean;
+		return std::partial_ordering::equivalent;
+	}
+	
+	/* * * * * * * * * * * * * * * * * * * *
+ * Projection
+ */
+	
+	Projection::Projection(std::initializer_list<std::string_view> paths)
+	{
+		for(std::string_view path:paths)
+			add(path);
+	}
+	
+	void Projection::add(std::string_view path)
+	{
+		if(m_nodes.empty())
+			m_nodes.emplace_back();
+		size_t node=0;
+		for(;;)
+		{
+			size_t const dot=path.find('.');
+			std::string_view const key=path.substr(0, dot);
+			auto& children=m_nodes[node].children;
+			auto const it=std::find_if(children.begin(), children.end(), [&](const auto& child){ return child.first==key; });
+			if(it!=children.end())
+				node=it->second;
+			else
+			{
+				children.emplace_back(key, m_nodes.size());
+				node=m_nodes.size();
+				m_nodes.emplace_back();
+			}
+			if(dot==std::string_view::npos)
+				break;
+			path.remove_prefix(dot+1);
+		}
+		m_nodes[node].whole=true;
+	}
+	
+	size_t Projection::find(size_t node, std::string_view key) const
+	{
+		for(const auto& child:m_nodes[node].children)
+		{
+			if(child.first==key)
+				return m_nodes[child.second].whole ? npos : child.second;
+		}
+		return skip();
+	}
+	
 	namespace
 	{
 		/* MsgPackParser
@@ -784,252 +1895,1131 @@ namespace msgpack11
  */
 		namespace MsgPackParser
 		{
-			MsgPack parse_msgpack(std::istream& is, int depth);
+			/* HeapNodes
+     *
+     * Default node allocation for the sources below: every value owns its
+     * own heap storage.
+     */
+			struct HeapNodes
+			{
+				std::pmr::memory_resource* resource() { return std::pmr::get_default_resource(); }
+				template<typename T>
+				MsgPack make(T&& value)      { return MsgPack(std::forward<T>(value)); }
+			};
 			
-			template< typename T >
-			void read_bytes(std::istream& is, T& bytes)
+			/* BufferSource
+     *
+     * Reads from a contiguous buffer through a raw cursor. Nothing is copied
+     * until a value is materialized.
+     */
+			class BufferSource : public HeapNodes
 			{
-				static_assert(std::is_trivially_copyable_v<T>,"byte read not guaranteed for non-primitive types");
-				int n = sizeof(T);
+			public:
+				BufferSource(const uint8_t* begin, const uint8_t* end):m_cur(begin),m_end(end){}
+				
+				bool get(uint8_t& byte)
+				{
+					if(m_cur==m_end)
+					{
+						m_eof=true;
+						return false;
+					}
+					byte=*m_cur++;
+					return true;
+				}
 				
-				int const offsets[]{(n-1), 0};
-				int const directions[]{-1, 1};
+				bool read(void* dst, size_t n)
+				{
+					if(static_cast<size_t>(m_end-m_cur)<n)
+					{
+						m_eof=true;
+						return false;
+					}
+					std::memcpy(dst, m_cur, n);
+					m_cur+=n;
+					return true;
+				}
 				
-				uint8_t* dst_ptr = reinterpret_cast<uint8_t*>(&bytes) + offsets[static_cast<int>(is_big_endian)];
-				int const dir = directions[static_cast<int>(is_big_endian)];
-				for(int i = 0; i < n; ++i)
+				// Point data at the next n bytes, in place.
+				bool read_view(size_t n, const uint8_t*& data)
 				{
-					*dst_ptr = is.get();
-					dst_ptr += dir;
+					if(static_cast<size_t>(m_end-m_cur)<n)
+					{
+						m_eof=true;
+						return false;
+					}
+					data=m_cur;
+					m_cur+=n;
+					return true;
 				}
-				// NB: if the read fails it's prefered to return 0 rather than
-				//      corrupted value, for example in the case of reading data size.
-				if (is.fail() || is.eof())
+				
+				// Stop reading max_bytes from here; running into that end
+				// counts as exceeding the limit rather than as truncation.
+				void limit(size_t max_bytes)
 				{
-					bytes = 0;
+					if(available()>max_bytes)
+					{
+						m_end=m_cur+max_bytes;
+						m_limited=true;
+					}
 				}
-			}
+				
+				size_t available()        const { return static_cast<size_t>(m_end-m_cur); }
+				void set_fail()                 { m_fail=true; }
+				bool failed()             const { return m_fail||m_eof; }
+				bool eof()                const { return m_eof; }
+				bool over_limit()         const { return m_eof&&m_limited; }
+				const uint8_t* position() const { return m_cur; }
+				
+			private:
+				const uint8_t* m_cur;
+				const uint8_t* m_end;
+				bool m_eof=false;
+				bool m_fail=false;
+				bool m_limited=false;
+			};
 			
-			/* fail(msg, err_ret = MsgPack())
+			/* StreamSource
      *
-     * Mark this parse as m_failed.
+     * Adapts std::istream to the BufferSource interface. Failures are
+     * reported through the stream state, as operator>> always did.
      */
-			MsgPack fail(std::istream& is)
-			{
-				is.setstate(std::ios::failbit);
-				return MsgPack();
-			}
-			
-			MsgPack parse_invalid(std::istream& is, uint8_t,size_t)
+			class StreamSource : public HeapNodes
 			{
-				return fail(is);
-			}
+			public:
+				explicit StreamSource(std::istream& is):m_is(is){}
+				
+				bool get(uint8_t& byte)
+				{
+					if(!take(1))
+						return false;
+					auto const c=m_is.get();
+					// check for fail/eof after get() as eof only set after read past the end
+					if(m_is.fail()||m_is.eof())
+					{
+						m_is.setstate(std::ios::failbit);
+						return false;
+					}
+					byte=static_cast<uint8_t>(c);
+					return true;
+				}
+				
+				bool read(void* dst, size_t n)
+				{
+					if(!take(n))
+						return false;
+					m_is.read(static_cast<char*>(dst), n);
+					return !failed();
+				}
+				
+				// Read the next n bytes into a scratch buffer and point data at
+				// them; they stay there until the next call.
+				bool read_view(size_t n, const uint8_t*& data)
+				{
+					// Checked before resizing, so a forged length within a
+					// limited parse never allocates past the limit.
+					if(n>m_budget)
+						return take(n);
+					m_scratch.resize(n);
+					data=m_scratch.data();
+					return read(m_scratch.data(), n);
+				}
+				
+				void limit(size_t max_bytes) { m_budget=max_bytes; }
+				
+				// Only what is already buffered counts; the rest may never come.
+				size_t available() const
+				{
+					std::streamsize const n=m_is.rdbuf() ? m_is.rdbuf()->in_avail() : 0;
+					return n>0 ? static_cast<size_t>(n) : 0;
+				}
+				void set_fail()         { m_is.setstate(std::ios::failbit); }
+				bool failed()     const { return m_is.fail()||m_is.eof(); }
+				bool eof()        const { return m_is.eof(); }
+				bool over_limit() const { return m_over_limit; }
+				
+			private:
+				bool take(size_t n)
+				{
+					if(n>m_budget)
+					{
+						m_over_limit=true;
+						set_fail();
+						return false;
+					}
+					m_budget-=n;
+					return true;
+				}
+				
+				std::istream& m_is;
+				std::vector<uint8_t> m_scratch;
+				size_t m_budget=std::numeric_limits<size_t>::max();
+				bool m_over_limit=false;
+			};
 			
-			MsgPack parse_nil(std::istream&, uint8_t,size_t)
+			/* ArenaNodes<Source>
+     *
+     * Reads through Source but allocates nodes and container storage from
+     * a Document's arena. Nodes whose payload still ends up on the heap are
+     * remembered in finalizers so the Document can release just those.
+     */
+			template<typename Source>
+			class ArenaNodes : public Source
 			{
-				return MsgPack();
-			}
+			public:
+				template<typename... Args>
+				ArenaNodes(std::pmr::memory_resource& resource, std::vector<std::shared_ptr<MsgPackValue>>& finalizers, Args&&... args):
+					Source(std::forward<Args>(args)...), m_resource(resource), m_finalizers(finalizers){}
+				
+				std::pmr::memory_resource* resource() { return &m_resource; }
+				
+				template<typename T>
+				MsgPack make(T&& value)
+				{
+					using V=std::decay_t<T>;
+					auto node=std::allocate_shared<Compound<V>>(std::pmr::polymorphic_allocator<Compound<V>>(&m_resource), std::forward<T>(value));
+					node->mark_in_arena();
+					if(owns_heap(node->m_value))
+						m_finalizers.push_back(node);
+					return adopt_msgpack(std::move(node));
+				}
+				
+			private:
+				static bool owns_heap(const MsgPack::string& value)    { return value.capacity()>MsgPack::string().capacity(); }
+				static bool owns_heap(const MsgPack::binary& value)    { return value.capacity()!=0; }
+				static bool owns_heap(const MsgPack::extension& value) { return std::get<1>(value).capacity()!=0; }
+				static bool owns_heap(const MsgPack::array&)           { return false; }
+				static bool owns_heap(const MsgPack::object&)          { return false; }
+				
+				std::pmr::memory_resource& m_resource;
+				std::vector<std::shared_ptr<MsgPackValue>>& m_finalizers;
+			};
 			
-			MsgPack parse_bool(std::istream&, uint8_t first_byte,size_t)
+			/* BorrowNodes
+     *
+     * Reads from a buffer like BufferSource, but makes strings and binaries
+     * that point into it, each holding owner, instead of copying them out.
+     */
+			class BorrowNodes : public BufferSource
 			{
-				return MsgPack(first_byte==0xc3);
-			}
+			public:
+				BorrowNodes(const uint8_t* begin, const uint8_t* end, std::shared_ptr<const void> owner):
+					BufferSource(begin, end), m_owner(std::move(owner)){}
+				
+				MsgPack borrow(std::string_view value)         { return adopt_msgpack(std::make_shared<Borrowed<MsgPack::string>>(value, m_owner)); }
+				MsgPack borrow(std::span<const uint8_t> value) { return adopt_msgpack(std::make_shared<Borrowed<MsgPack::binary>>(value, m_owner)); }
+				
+			private:
+				std::shared_ptr<const void> m_owner;
+			};
 			
-			template< typename T >
-			MsgPack parse_arith(std::istream& is, uint8_t,size_t)
+			template<typename Source, typename T>
+			bool read_bytes(Source& src, T& bytes)
 			{
-				T tmp;
-				read_bytes(is, tmp);
-				return MsgPack(tmp);
+				static_assert(std::is_trivially_copyable_v<T>,"byte read not guaranteed for non-primitive types");
+				uint8_t raw[sizeof(T)];
+				if(!src.read(raw, sizeof(T)))
+					return false;
+				bytes = load_big_endian<T>(raw);
+				return true;
 			}
 			
-			inline std::string parse_string_impl(std::istream& is, uint32_t bytes)
+			/* Reader<Source, Handler>
+     *
+     * The one decoder: reads tokens from Source and reports each as an
+     * event to Handler, with no tree in between. Open arrays and maps are
+     * kept on an explicit stack rather than by recursing, so nesting costs
+     * one entry rather than a chain of call frames.
+     *
+     * Handler receives nil(), boolean(), number(T) with the encoded type
+     * of the number, string(), binary(), extension(), begin_array(n),
+     * begin_map(n), end_array() and end_map(). Payloads are views into
+     * Source that are only valid during the call.
+     *
+     * All progress lives in the Reader rather than on the call stack, so a
+     * read that runs out of input can pick up again from the same point
+     * once the source has more; see MsgPackStreamParser.
+     */
+			template<typename Source, typename Handler>
+			class Reader
 			{
-				std::string ret;
-				ret.resize(bytes);
-				is.read(&ret[0], bytes);
-				return ret;
-			}
+			public:
+				enum class Step { MORE, DONE, FAILED };
+				
+				Reader(Source& src, Handler& handler, const ParseOptions& options):
+					m_src(src),m_handler(handler),m_options(options),m_root_filter(options.keep_keys.empty() ? Projection::npos : 0)
+				{
+					src.limit(options.max_bytes);
+				}
+				
+				// Read one token and report its events, including the ends of
+				// the containers it completes. Events are only reported once the
+				// whole token is in, so a step that fails because the source ran
+				// dry leaves the read as it was before the step began.
+				Step step();
+				
+				// Read a whole value.
+				bool read()
+				{
+					for(;;)
+					{
+						switch(step())
+						{
+							case Step::MORE:   continue;
+							case Step::DONE:   return true;
+							case Step::FAILED: return false;
+						}
+					}
+				}
+				
+				// Start on the next value.
+				void restart() { m_elements=0; }
+				
+				// Values read so far, arrays and maps included.
+				size_t elements() const { return m_elements; }
+				
+				// True if the last failure was only running out of input.
+				bool truncated() const { return m_src.eof()&&!m_src.over_limit()&&!m_limit_error; }
+				
+				// Assign the reason the read failed, if it did, to err.
+				void report(std::string& err) const
+				{
+					if(m_limit_error)
+						err=m_limit_error;
+					else if(m_src.over_limit())
+						err="exceeded maximum size.";
+					else if(m_src.eof())
+						err="end of buffer.";
+					else if(m_src.failed())
+						err="format error.";
+				}
+				
+			private:
+				enum class Kind { VALUE, ARRAY, OBJECT };
+				
+				// An array or map whose members are still being read; a map
+				// counts its keys and values separately. filter is the
+				// projection node for the maps inside, Projection::npos if
+				// they are read whole or Projection::skip() if nothing in
+				// here is reported; next is the one for the value of the
+				// current key.
+				struct Open
+				{
+					uint64_t remaining;
+					bool is_object;
+					size_t filter=Projection::npos;
+					size_t next=Projection::npos;
+				};
+				
+				// Handler for what a projection skips: drops every event, but
+				// keeps the last string for telling which key was read.
+				struct Skipped
+				{
+					std::string_view key;
+					
+					void nil()                                         {}
+					void boolean(bool)                                 {}
+					template<typename T>
+					void number(T)                                     {}
+					void string(std::string_view value)                { key=value; }
+					void binary(std::span<const uint8_t>)              {}
+					void extension(uint8_t, std::span<const uint8_t>)  {}
+				};
+				
+				template<typename H>
+				Kind read_token(H& handler, uint8_t first_byte, uint32_t& count);
+				
+				template<typename T, typename H>
+				void read_number(H& handler)
+				{
+					T value;
+					if(read_bytes(m_src, value))
+						handler.number(value);
+				}
+				
+				template<typename T>
+				uint32_t read_length()
+				{
+					T bytes;
+					return read_bytes(m_src, bytes) ? static_cast<uint32_t>(bytes) : 0;
+				}
+				
+				// The lengths are only acted on once read, so that a truncated
+				// header reports nothing.
+				template<typename T, typename H>
+				void read_string(H& handler)
+				{
+					T bytes;
+					if(read_bytes(m_src, bytes))
+						read_string(handler, bytes);
+				}
+				
+				template<typename T, typename H>
+				void read_binary(H& handler)
+				{
+					T bytes;
+					if(read_bytes(m_src, bytes))
+						read_binary(handler, bytes);
+				}
+				
+				template<typename T, typename H>
+				void read_extension(H& handler)
+				{
+					T bytes;
+					if(read_bytes(m_src, bytes))
+						read_extension(handler, bytes);
+				}
+				
+				template<typename H>
+				void read_string(H& handler, uint32_t bytes)
+				{
+					const uint8_t* data;
+					if(m_src.read_view(bytes, data))
+						handler.string(std::string_view(reinterpret_cast<const char*>(data), bytes));
+				}
+				
+				template<typename H>
+				void read_binary(H& handler, uint32_t bytes)
+				{
+					const uint8_t* data;
+					if(m_src.read_view(bytes, data))
+						handler.binary(std::span<const uint8_t>(data, bytes));
+				}
+				
+				template<typename H>
+				void read_extension(H& handler, uint32_t bytes)
+				{
+					uint8_t type;
+					const uint8_t* data;
+					if(read_bytes(m_src, type) && m_src.read_view(bytes, data))
+						handler.extension(type, std::span<const uint8_t>(data, bytes));
+				}
+				
+				Step fail(const char* limit_error=nullptr)
+				{
+					m_limit_error=limit_error;
+					m_src.set_fail();
+					return Step::FAILED;
+				}
+				
+				Source& m_src;
+				Handler& m_handler;
+				const ParseOptions& m_options;
+				std::vector<Open> m_stack;
+				size_t m_elements=0;
+				const char* m_limit_error=nullptr;
+				size_t const m_root_filter;
+				Skipped m_skipped;
+			};
 			
-			template< typename T >
-			MsgPack parse_string(std::istream& is, uint8_t, size_t)
+			/* read_token()
+     *
+     * Dispatch on the lead byte. The fix formats cover most nodes in
+     * practice, so they are tested first; the rest is a dense switch the
+     * compiler turns into a jump table. Arrays and maps only have their
+     * header read here, with their size left in count.
+     */
+			template<typename Source, typename Handler>
+			template<typename H>
+			inline typename Reader<Source, Handler>::Kind Reader<Source, Handler>::read_token(H& handler, uint8_t first_byte, uint32_t& count)
 			{
-				T bytes;
-				read_bytes(is, bytes);
-				return MsgPack(parse_string_impl(is, static_cast<uint32_t>(bytes)));
+				if(first_byte <= 0x7f)
+				{
+					handler.number(static_cast<uint8_t>(first_byte));
+					return Kind::VALUE;
+				}
+				if(first_byte >= 0xe0)
+				{
+					handler.number(static_cast<int8_t>(first_byte));
+					return Kind::VALUE;
+				}
+				if(first_byte <= 0x8f)
+				{
+					count=first_byte & 0x0f;
+					return Kind::OBJECT;
+				}
+				if(first_byte <= 0x9f)
+				{
+					count=first_byte & 0x0f;
+					return Kind::ARRAY;
+				}
+				if(first_byte <= 0xbf)
+				{
+					read_string(handler, first_byte & 0x1f);
+					return Kind::VALUE;
+				}
+				
+				switch(first_byte)
+				{
+					case 0xc0: handler.nil(); break;
+					case 0xc2:
+					case 0xc3: handler.boolean(first_byte==0xc3); break;
+					case 0xc4: read_binary<uint8_t>(handler); break;
+					case 0xc5: read_binary<uint16_t>(handler); break;
+					case 0xc6: read_binary<uint32_t>(handler); break;
+					case 0xc7: read_extension<uint8_t>(handler); break;
+					case 0xc8: read_extension<uint16_t>(handler); break;
+					case 0xc9: read_extension<uint32_t>(handler); break;
+					case 0xca: read_number<float>(handler); break;
+					case 0xcb: read_number<double>(handler); break;
+					case 0xcc: read_number<uint8_t>(handler); break;
+					case 0xcd: read_number<uint16_t>(handler); break;
+					case 0xce: read_number<uint32_t>(handler); break;
+					case 0xcf: read_number<uint64_t>(handler); break;
+					case 0xd0: read_number<int8_t>(handler); break;
+					case 0xd1: read_number<int16_t>(handler); break;
+					case 0xd2: read_number<int32_t>(handler); break;
+					case 0xd3: read_number<int64_t>(handler); break;
+					case 0xd4:
+					case 0xd5:
+					case 0xd6:
+					case 0xd7:
+					case 0xd8: read_extension(handler, 1u << (first_byte - 0xd4u)); break;
+					case 0xd9: read_string<uint8_t>(handler); break;
+					case 0xda: read_string<uint16_t>(handler); break;
+					case 0xdb: read_string<uint32_t>(handler); break;
+					case 0xdc: count=read_length<uint16_t>(); return Kind::ARRAY;
+					case 0xdd: count=read_length<uint32_t>(); return Kind::ARRAY;
+					case 0xde: count=read_length<uint16_t>(); return Kind::OBJECT;
+					case 0xdf: count=read_length<uint32_t>(); return Kind::OBJECT;
+					default  : m_src.set_fail(); break;
+				}
+				return Kind::VALUE;
 			}
 			
-			MsgPack::array parse_array_impl(std::istream& is, uint32_t bytes,size_t depth)
+			template<typename Source, typename Handler>
+			inline typename Reader<Source, Handler>::Step Reader<Source, Handler>::step()
 			{
-				MsgPack::array res;
-//				res.reserve(bytes);
+				uint8_t first_byte;
+				if(!m_src.get(first_byte))
+					return fail();
+				if(m_elements >= m_options.max_elements)
+					return fail("exceeded maximum number of elements.");
+				
+				// Which projection applies to this token. A key of a map the
+				// projection looks into is read without being reported, and
+				// only reported once it is known to be kept.
+				size_t filter=m_root_filter;
+				bool projected_key=false;
+				if(!m_stack.empty())
+				{
+					Open const& top=m_stack.back();
+					if(!top.is_object)
+						filter=top.filter;
+					else if(top.remaining&1)
+						filter=top.next;
+					else
+					{
+						filter=top.filter;
+						projected_key=filter<Projection::skip();
+					}
+				}
+				bool const reported=filter!=Projection::skip()&&!projected_key;
+				
+				uint32_t count=0;
+				m_skipped.key={};
+				Kind const kind=reported ? read_token(m_handler, first_byte, count) : read_token(m_skipped, first_byte, count);
+				if(m_src.failed())
+					return fail();
+				++m_elements;
+				
+				if(projected_key)
+				{
+					// A key that is not a string is never kept, nor is anything
+					// inside it.
+					bool const is_string=(first_byte >= 0xa0 && first_byte <= 0xbf) || (first_byte >= 0xd9 && first_byte <= 0xdb);
+					size_t const next=is_string ? m_options.keep_keys.find(filter, m_skipped.key) : Projection::skip();
+					if(next!=Projection::skip())
+						m_handler.string(m_skipped.key);
+					m_stack.back().next=next;
+					filter=Projection::skip();
+				}
+				
+				if(kind!=Kind::VALUE)
+				{
+					if(m_stack.size() >= m_options.max_depth)
+						return fail("exceeded maximum depth.");
+					if(filter!=Projection::skip())
+					{
+						if(kind==Kind::ARRAY)
+							m_handler.begin_array(count);
+						else
+							m_handler.begin_map(filter==Projection::npos ? count : std::min<size_t>(count, m_options.keep_keys.size(filter)));
+					}
+					if(count)
+					{
+						m_stack.push_back({kind==Kind::OBJECT ? 2*uint64_t(count) : count, kind==Kind::OBJECT, filter, filter==Projection::skip() ? filter : Projection::npos});
+						return Step::MORE;
+					}
+					if(filter!=Projection::skip())
+					{
+						if(kind==Kind::ARRAY)
+							m_handler.end_array();
+						else
+							m_handler.end_map();
+					}
+				}
 				
-				for(uint32_t i = 0; i < bytes; ++i)
+				// A value is complete: close every container this completes.
+				while(!m_stack.empty())
 				{
-					res.push_back(parse_msgpack(is, depth));
+					Open& top=m_stack.back();
+					if(--top.remaining)
+						return Step::MORE;
+					if(top.filter!=Projection::skip())
+					{
+						if(top.is_object)
+							m_handler.end_map();
+						else
+							m_handler.end_array();
+					}
+					m_stack.pop_back();
 				}
-				return res;
+				return Step::DONE;
 			}
 			
-			template< typename T >
-			MsgPack parse_array(std::istream& is, uint8_t, size_t depth)
+			/* Builder<Nodes>
+     *
+     * Reader handler that assembles the events into a MsgPack, allocating
+     * through Nodes.
+     */
+			template<typename Nodes>
+			class Builder
 			{
-				T bytes;
-				read_bytes(is, bytes);
-				return MsgPack(parse_array_impl(is, static_cast<uint32_t>(bytes), depth));
-			}
+			public:
+				explicit Builder(Nodes& nodes):m_nodes(nodes){}
+				
+				void nil()                                  { place(nullptr); }
+				void boolean(bool value)                    { place(value); }
+				template<typename T>
+				void number(T value)                        { place(value); }
+				void string(std::string_view value)
+				{
+					if constexpr(requires{ m_nodes.borrow(value); })
+						place(m_nodes.borrow(value));
+					else
+						place(m_nodes.make(MsgPack::string(value)));
+				}
+				void binary(std::span<const uint8_t> value)
+				{
+					if constexpr(requires{ m_nodes.borrow(value); })
+						place(m_nodes.borrow(value));
+					else
+						place(m_nodes.make(MsgPack::binary(value.begin(), value.end())));
+				}
+				void extension(uint8_t type, std::span<const uint8_t> value)
+				{
+					place(m_nodes.make(MsgPack::extension(type, MsgPack::binary(value.begin(), value.end()))));
+				}
+				
+				// Every element takes at least one byte and every entry two, so
+				// a forged length cannot reserve more than the input could hold.
+				void begin_array(uint32_t count)
+				{
+					m_stack.emplace_back(false, m_nodes.resource()).array.reserve(std::min<size_t>(count, m_nodes.available()));
+				}
+				void begin_map(uint32_t count)
+				{
+					m_stack.emplace_back(true, m_nodes.resource()).object.reserve(std::min<size_t>(count, m_nodes.available()/2));
+				}
+				void end_array() { close(); }
+				void end_map()   { close(); }
+				
+				// Hand over the completed value.
+				MsgPack take() { return std::move(m_root); }
+				
+			private:
+				// An array or map whose members are still being added.
+				struct Frame
+				{
+					Frame(bool is_object, std::pmr::memory_resource* resource):array(resource),object(resource),is_object(is_object){}
+					
+					MsgPack::array array;
+					MsgPack::object object;
+					MsgPack key;
+					bool is_object;
+					bool has_key=false;
+				};
+				
+				// Construct value where it belongs: the root, the next element
+				// of the innermost array, or the key or value of the innermost
+				// map.
+				template<typename T>
+				void place(T&& value)
+				{
+					if(m_stack.empty())
+					{
+						m_root=MsgPack(std::forward<T>(value));
+						return;
+					}
+					Frame& top=m_stack.back();
+					if(!top.is_object)
+						top.array.emplace_back(std::forward<T>(value));
+					else if(!top.has_key)
+					{
+						top.key=MsgPack(std::forward<T>(value));
+						top.has_key=true;
+					}
+					else
+					{
+						top.object.emplace(std::move(top.key), std::forward<T>(value));
+						top.has_key=false;
+					}
+				}
+				
+				void close()
+				{
+					Frame& top=m_stack.back();
+					MsgPack closed=top.is_object ? m_nodes.make(std::move(top.object)) : m_nodes.make(std::move(top.array));
+					m_stack.pop_back();
+					place(std::move(closed));
+				}
+				
+				Nodes& m_nodes;
+				std::vector<Frame> m_stack;
+				MsgPack m_root;
+			};
 			
-			MsgPack::object parse_object_impl(std::istream& is, uint32_t bytes,size_t depth)
+			/* Parser<Source>
+     *
+     * The DOM parse: a Reader feeding a Builder.
+     */
+			template<typename Source>
+			class Parser
 			{
-				MsgPack::object res;
+			public:
+				using Step=typename Reader<Source, Builder<Source>>::Step;
+				
+				Parser(Source& src, const ParseOptions& options):m_builder(src),m_reader(src, m_builder, options){}
 				
-				for(uint32_t i = 0; i < bytes; ++i)
+				MsgPack parse()
 				{
-					MsgPack key=parse_msgpack(is, depth);
-					MsgPack value=parse_msgpack(is, depth);
-					res.insert(std::make_pair(std::move(key), std::move(value)));
+					return m_reader.read() ? m_builder.take() : MsgPack();
 				}
-				return res;
-			}
+				
+				bool read()                         { return m_reader.read(); }
+				Step step()                         { return m_reader.step(); }
+				size_t elements()             const { return m_reader.elements(); }
+				bool truncated()              const { return m_reader.truncated(); }
+				void report(std::string& err) const { m_reader.report(err); }
+				
+				// Hand over the completed value and start on the next one.
+				MsgPack take()
+				{
+					m_reader.restart();
+					return m_builder.take();
+				}
+				
+			private:
+				Builder<Source> m_builder;
+				Reader<Source, Builder<Source>> m_reader;
+			};
 			
-			template< typename T >
-			MsgPack parse_object(std::istream& is, uint8_t,size_t depth)
+			/* VisitorHandler
+     *
+     * Reader handler that forwards the events to a MsgPackVisitor.
+     */
+			class VisitorHandler
 			{
-				T bytes;
-				read_bytes(is, bytes);
-				return MsgPack(parse_object_impl(is, static_cast<uint32_t>(bytes), depth));
-			}
+			public:
+				explicit VisitorHandler(MsgPackVisitor& visitor):m_visitor(visitor){}
+				
+				void nil()                                  { m_visitor.on_nil(); }
+				void boolean(bool value)                    { m_visitor.on_bool(value); }
+				template<typename T>
+				void number(T value)
+				{
+					if constexpr(std::is_floating_point_v<T>)
+						m_visitor.on_float(value);
+					else if constexpr(std::is_signed_v<T>)
+						m_visitor.on_int(value);
+					else
+						m_visitor.on_uint(value);
+				}
+				void string(std::string_view value)         { m_visitor.on_str(value); }
+				void binary(std::span<const uint8_t> value) { m_visitor.on_bin(value); }
+				void extension(uint8_t type, std::span<const uint8_t> value) { m_visitor.on_ext(type, value); }
+				void begin_array(uint32_t count)            { m_visitor.begin_array(count); }
+				void begin_map(uint32_t count)              { m_visitor.begin_map(count); }
+				void end_array()                            { m_visitor.end_array(); }
+				void end_map()                              { m_visitor.end_map(); }
+				
+			private:
+				MsgPackVisitor& m_visitor;
+			};
 			
-			MsgPack::binary parse_binary_impl(std::istream& is, uint32_t bytes)
+			/* parse_buffer()
+     *
+     * Parse one value from src, assigning an error message to err on
+     * failure.
+     */
+			template<typename Source>
+			MsgPack parse_buffer(Source& src, std::string& err, const ParseOptions& options)
 			{
-				MsgPack::binary ret;
-				ret.resize(bytes);
-				is.read(reinterpret_cast<char*>(ret.data()),bytes);
+				Parser<Source> parser(src, options);
+				MsgPack ret=parser.parse();
+				parser.report(err);
 				return ret;
 			}
 			
-			template< typename T >
-			MsgPack parse_binary(std::istream& is, uint8_t,size_t)
-			{
-				T bytes;
-				read_bytes(is,bytes);
-				return MsgPack(parse_binary_impl(is,static_cast<uint32_t>(bytes)));
-			}
-			
-			template< typename T >
-			MsgPack parse_extension(std::istream& is, uint8_t,size_t)
-			{
-				T bytes;
-				read_bytes(is, bytes);
-				uint8_t type;
-				read_bytes(is, type);
-				const MsgPack::binary data=parse_binary_impl(is, static_cast<uint32_t>(bytes));
-				return MsgPack(std::make_tuple(type, std::move(data)));
-			}
-			
-			MsgPack parse_pos_fixint(std::istream&, uint8_t first_byte, size_t)
-			{
-				return MsgPack( first_byte );
-			}
-			
-			MsgPack parse_fixobject(std::istream& is, uint8_t first_byte,size_t depth)
+			MsgPack parse_buffer(const uint8_t*& cur, const uint8_t* end, std::string& err, const ParseOptions& options)
 			{
-				uint32_t const bytes = first_byte & 0x0f;
-				return MsgPack(parse_object_impl(is, bytes, depth));
+				BufferSource src(cur, end);
+				MsgPack ret=parse_buffer(src, err, options);
+				cur=src.position();
+				return ret;
 			}
 			
-			MsgPack parse_fixarray(std::istream& is, uint8_t first_byte,size_t depth)
+			/* token_size()
+     *
+     * Encoded size of the token starting at p: a whole scalar, string,
+     * binary or extension, or just the header of an array or map. Returns
+     * 0 if the n bytes available do not yet hold enough of the header to
+     * tell.
+     */
+			uint64_t token_size(const uint8_t* p, size_t n)
 			{
-				uint32_t const bytes = first_byte & 0x0f;
-				return MsgPack(parse_array_impl(is, bytes, depth));
+				if(!n)
+					return 0;
+				uint8_t const first_byte=p[0];
+				if(first_byte <= 0x9f || first_byte >= 0xe0)
+					return 1;
+				if(first_byte <= 0xbf)
+					return 1+(first_byte & 0x1f);
+				
+				// Formats with a length field: its width and the bytes that
+				// precede the payload.
+				size_t width=0;
+				size_t header=0;
+				switch(first_byte)
+				{
+					case 0xc4: case 0xd9: width=1; header=2; break;
+					case 0xc5: case 0xda: width=2; header=3; break;
+					case 0xc6: case 0xdb: width=4; header=5; break;
+					case 0xc7: width=1; header=3; break;
+					case 0xc8: width=2; header=4; break;
+					case 0xc9: width=4; header=6; break;
+					case 0xca: case 0xce: case 0xd2: return 5;
+					case 0xcb: case 0xcf: case 0xd3: return 9;
+					case 0xcc: case 0xd0: return 2;
+					case 0xcd: case 0xd1: return 3;
+					case 0xd4: case 0xd5: case 0xd6: case 0xd7: case 0xd8:
+						return 2+(1u << (first_byte - 0xd4u));
+					case 0xdc: case 0xde: return 3;
+					case 0xdd: case 0xdf: return 5;
+					default: return 1;
+				}
+				if(n < 1+width)
+					return 0;
+				uint64_t length=0;
+				switch(width)
+				{
+					case 1: length=p[1]; break;
+					case 2: length=load_big_endian<uint16_t>(p+1); break;
+					case 4: length=load_big_endian<uint32_t>(p+1); break;
+				}
+				return header+length;
 			}
 			
-			MsgPack parse_fixstring(std::istream& is, uint8_t first_byte,size_t)
+			/* members()
+     *
+     * How many values follow the complete token at p as its members: the
+     * elements of an array, the keys and values of a map, 0 otherwise.
+     */
+			uint64_t members(const uint8_t* p)
 			{
-				uint32_t const bytes = first_byte & 0x1f;
-				return MsgPack(parse_string_impl(is, bytes));
+				uint8_t const first_byte=p[0];
+				if(first_byte >= 0x80 && first_byte <= 0x8f)
+					return 2*(first_byte & 0x0f);
+				if(first_byte >= 0x90 && first_byte <= 0x9f)
+					return first_byte & 0x0f;
+				switch(first_byte)
+				{
+					case 0xdc: return load_big_endian<uint16_t>(p+1);
+					case 0xdd: return load_big_endian<uint32_t>(p+1);
+					case 0xde: return 2*uint64_t(load_big_endian<uint16_t>(p+1));
+					case 0xdf: return 2*uint64_t(load_big_endian<uint32_t>(p+1));
+					default  : return 0;
+				}
 			}
 			
-			MsgPack parse_neg_fixint(std::istream&, uint8_t first_byte, size_t)
+			/* fixint_run()
+     *
+     * How many of the 8 bytes at p, counting from the first, are fixints,
+     * tested with one load: a byte is a fixint if its top bit is clear or
+     * its top three bits are all set.
+     */
+			inline size_t fixint_run(const uint8_t* p)
 			{
-				return MsgPack(*reinterpret_cast<int8_t*>(&first_byte));
+				uint64_t word;
+				std::memcpy(&word, p, sizeof(word));
+				uint64_t const others=word & 0x8080808080808080ULL & ~((word<<1) & (word<<2));
+				if(!others)
+					return 8;
+				if constexpr(std::endian::native==std::endian::little)
+					return std::countr_zero(others)/8;
+				else
+					return std::countl_zero(others)/8;
 			}
 			
-			MsgPack parse_fixext(std::istream& is, uint8_t first_byte, size_t)
+			/* NoChecks
+     *
+     * Skip policy for input that only has to be well-formed. Containers
+     * just add their members to the count still owed.
+     */
+			struct NoChecks
 			{
-				uint8_t type;
-				read_bytes(is, type);
-				uint32_t const BYTES = 1 << (first_byte - 0xd4u);
-				const MsgPack::binary data = parse_binary_impl(is, BYTES);
-				return MsgPack(std::make_tuple(type, std::move(data)));
-			}
+				bool open(uint64_t& owed, uint64_t members) { owed+=members; return true; }
+				bool close(uint64_t&)                       { return false; }
+				uint64_t room()                       const { return std::numeric_limits<uint64_t>::max(); }
+				bool count(uint64_t)                        { return true; }
+				void fail(const uint8_t*, const char*)      {}
+			};
 			
-			/* parse_msgpack()
+			/* LimitChecks
      *
-     * Parse a JSON object.
+     * Skip policy that enforces ParseOptions the way Reader does, keeping
+     * the count owed by each open container so that depth is known.
      */
-			MsgPack parse_msgpack(std::istream& is, int depth)
-			{
-				static const std::array<std::function<MsgPack(std::istream&,uint8_t,size_t)>,256>parsers{[]()
-				{
-					using parser_map_type=std::pair<uint8_t,std::function<MsgPack(std::istream&,uint8_t,size_t)>>;
-					std::array<parser_map_type,36> const parser_template
-					{{
-						parser_map_type{0x7fu,MsgPackParser::parse_pos_fixint},
-						parser_map_type{0x8fu,MsgPackParser::parse_fixobject},
-						parser_map_type{0x9fu,MsgPackParser::parse_fixarray},
-						parser_map_type{0xbfu,MsgPackParser::parse_fixstring},
-						parser_map_type{0xc0u,MsgPackParser::parse_nil},
-						parser_map_type{0xc1u,MsgPackParser::parse_invalid},
-						parser_map_type{0xc3u,MsgPackParser::parse_bool},
-						parser_map_type{0xc4u,MsgPackParser::parse_binary<uint8_t>},
-						parser_map_type{0xc5u,MsgPackParser::parse_binary<uint16_t>},
-						parser_map_type{0xc6u,MsgPackParser::parse_binary<uint32_t>},
-						parser_map_type{0xc7u,MsgPackParser::parse_extension<uint8_t>},
-						parser_map_type{0xc8u,MsgPackParser::parse_extension<uint16_t>},
-						parser_map_type{0xc9u,MsgPackParser::parse_extension<uint32_t>},
-						parser_map_type{0xcau,MsgPackParser::parse_arith<float>},
-						parser_map_type{0xcbu,MsgPackParser::parse_arith<double>},
-						parser_map_type{0xccu,MsgPackParser::parse_arith<uint8_t>},
-						parser_map_type{0xcdu,MsgPackParser::parse_arith<uint16_t>},
-						parser_map_type{0xceu,MsgPackParser::parse_arith<uint32_t>},
-						parser_map_type{0xcfu,MsgPackParser::parse_arith<uint64_t>},
-						parser_map_type{0xd0u,MsgPackParser::parse_arith<int8_t>},
-						parser_map_type{0xd1u,MsgPackParser::parse_arith<int16_t>},
-						parser_map_type{0xd2u,MsgPackParser::parse_arith<int32_t>},
-						parser_map_type{0xd3u,MsgPackParser::parse_arith<int64_t>},
-						parser_map_type{0xd8u,MsgPackParser::parse_fixext},
-						parser_map_type{0xd9u,MsgPackParser::parse_string<uint8_t>},
-						parser_map_type{0xdau,MsgPackParser::parse_string<uint16_t>},
-						parser_map_type{0xdbu,MsgPackParser::parse_string<uint32_t>},
-						parser_map_type{0xdcu,MsgPackParser::parse_array<uint16_t>},
-						parser_map_type{0xddu,MsgPackParser::parse_array<uint32_t>},
-						parser_map_type{0xdeu,MsgPackParser::parse_object<uint16_t>},
-						parser_map_type{0xdfu,MsgPackParser::parse_object<uint32_t>},
-						parser_map_type{0xffu,MsgPackParser::parse_neg_fixint}
-					}};
-					
-					std::array<std::function<MsgPack(std::istream&,uint8_t,size_t)>,256> parsers;
-					int i=0;
-					for(const auto &parser:parser_template)
-						for(;i<=parser.first;i++)
-							parsers[i]=parser.second;
-					return parsers;
-				}()};
-				auto const first_byte{is.get()};
-				// check for fail/eof after get() as eof only set after read past the end
-				if (is.fail() || is.eof())
+			class LimitChecks
+			{
+			public:
+				explicit LimitChecks(const ParseOptions& options):m_options(options){}
+				
+				bool open(uint64_t& owed, uint64_t members)
 				{
-					return fail(is);
+					if(m_stack.size() >= m_options.max_depth)
+						return false;
+					m_stack.push_back(owed);
+					owed=members;
+					return true;
+				}
+				bool close(uint64_t& owed)
+				{
+					if(m_stack.empty())
+						return false;
+					owed=m_stack.back();
+					m_stack.pop_back();
+					return true;
+				}
+				uint64_t room() const { return m_options.max_elements-m_elements; }
+				bool count(uint64_t n)
+				{
+					if(n > room())
+						return false;
+					m_elements+=n;
+					return true;
+				}
+				void fail(const uint8_t* at, const char* error)
+				{
+					m_at=at;
+					m_error=error;
 				}
 				
-				MsgPack ret=parsers.at(first_byte)(is,first_byte,depth+1);
-				
-				if (is.fail() || is.eof())
+				void restart()
 				{
-					return fail(is);
+					m_stack.clear();
+					m_elements=0;
 				}
-				return ret;
+				const uint8_t* at()   const { return m_at; }
+				const char* error()   const { return m_error; }
+				
+			private:
+				const ParseOptions& m_options;
+				std::vector<uint64_t> m_stack;
+				size_t m_elements=0;
+				const uint8_t* m_at=nullptr;
+				const char* m_error=nullptr;
+			};
+			
+			/* skip()
+     *
+     * The skip kernel: find the end of the value starting at p without
+     * decoding it, or return nullptr if it is malformed, runs past end or
+     * breaks a check. Runs of fixints are stepped over eight bytes at a
+     * time, and strings, binaries and extensions are jumped over by their
+     * length. limit_end is where the input really ends, so that running
+     * into an end imposed by max_bytes can be told from truncation. owed
+     * values are skipped in all, back to back.
+     */
+			template<typename Checks>
+			const uint8_t* skip(const uint8_t* p, const uint8_t* end, const uint8_t* limit_end, Checks& checks, uint64_t owed=1)
+			{
+				for(;;)
+				{
+					if(!owed)
+					{
+						if(checks.close(owed))
+							continue;
+						return p;
+					}
+					size_t const available=static_cast<size_t>(end-p);
+					if(available >= 8)
+					{
+						uint64_t const run=std::min<uint64_t>({fixint_run(p), owed, checks.room()});
+						if(run)
+						{
+							checks.count(run);
+							p+=run;
+							owed-=run;
+							continue;
+						}
+					}
+					
+					uint64_t const size=token_size(p, available);
+					if(!size || size>available)
+					{
+						checks.fail(p, end!=limit_end ? "exceeded maximum size." : "end of buffer.");
+						return nullptr;
+					}
+					if(p[0]==0xc1)
+					{
+						checks.fail(p, "format error.");
+						return nullptr;
+					}
+					if(!checks.count(1))
+					{
+						checks.fail(p, "exceeded maximum number of elements.");
+						return nullptr;
+					}
+					--owed;
+					uint8_t const first_byte=p[0];
+					if((first_byte >= 0x80 && first_byte <= 0x9f) || (first_byte >= 0xdc && first_byte <= 0xdf))
+					{
+						if(!checks.open(owed, members(p)))
+						{
+							checks.fail(p, "exceeded maximum depth.");
+							return nullptr;
+						}
+					}
+					p+=size;
+				}
+			}
+			
+			const uint8_t* skip_value(const uint8_t* p, const uint8_t* end, uint64_t count=1)
+			{
+				NoChecks checks;
+				return skip(p, end, end, checks, count);
+			}
+			
+			/* validate()
+     *
+     * Skip count values from cur, or every value up to end if count is 0,
+     * checking each against options. On failure assign an error message
+     * to err, leave cur at the value at fault and return false.
+     */
+			bool validate(const uint8_t*& cur, const uint8_t* end, size_t count, std::string& err, const ParseOptions& options)
+			{
+				LimitChecks checks(options);
+				for(size_t i=0; count ? i<count : cur!=end; ++i)
+				{
+					checks.restart();
+					const uint8_t* const limit=static_cast<size_t>(end-cur)>options.max_bytes ? cur+options.max_bytes : end;
+					const uint8_t* const next=skip(cur, limit, end, checks);
+					if(!next)
+					{
+						err=checks.error();
+						cur=checks.at();
+						return false;
+					}
+					cur=next;
+				}
+				return true;
+			}
+			
+			/* decode_all()
+     *
+     * Decode the values that start at each of bounds but the last, which
+     * is where the last of them ends, into values. The work is split on up
+     * to threads threads, each taking a run of neighbouring values of about
+     * the same total size. Returns the number of values, or the index of
+     * the first that fails, with its error message assigned to err.
+     * elements adds up what Reader counted for the values decoded. What a
+     * run throws, say std::bad_alloc, is rethrown once every thread is
+     * joined, as the sequential parse() would have thrown it.
+     */
+			size_t decode_all(const std::vector<const uint8_t*>& bounds, std::vector<MsgPack>& values, std::string& err, size_t& elements, const ParseOptions& options, unsigned threads)
+			{
+				size_t const count=bounds.size()-1;
+				values.resize(count);
+				threads=static_cast<unsigned>(std::clamp<size_t>(count, 1, std::max(threads, 1u)));
+				
+				std::vector<size_t> splits(threads+1, count);
+				splits[0]=0;
+				size_t const total=bounds[count]-bounds[0];
+				for(unsigned t=1; t<threads; ++t)
+				{
+					const uint8_t* const target=bounds[0]+total/threads*t;
+					splits[t]=std::lower_bound(bounds.begin()+splits[t-1], bounds.begin()+count, target)-bounds.begin();
+				}
+				
+				// Bounds came from skipping, so max_bytes has been applied to
+				// each value already; it must not apply to a run of them.
+				ParseOptions run_options=options;
+				run_options.max_bytes=std::numeric_limits<size_t>::max();
+				struct Run
+				{
+					size_t failed;
+					std::string err;
+					size_t elements=0;
+					std::exception_ptr thrown;
+				};
+				std::vector<Run> runs(threads);
+				auto const decode_run=[&](unsigned t)
+				{
+					Run& run=runs[t];
+					run.failed=count;
+					try
+					{
+						BufferSource src(bounds[splits[t]], bounds[splits[t+1]]);
+						Parser<BufferSource> parser(src, run_options);
+						for(size_t i=splits[t]; i<splits[t+1]; ++i)
+						{
+							if(!parser.read())
+							{
+								run.failed=i;
+								parser.report(run.err);
+								return;
+							}
+							run.elements+=parser.elements();
+							values[i]=parser.take();
+						}
+					}
+					catch(...)
+					{
+						run.thrown=std::current_exception();
+					}
+				};
+				
+				{
+					// Joined on the way out of this block, even when starting
+					// one of them throws.
+					std::vector<std::jthread> workers;
+					workers.reserve(threads-1);
+					for(unsigned t=1; t<threads; ++t)
+						workers.emplace_back(decode_run, t);
+					decode_run(0);
+				}
+				
+				// In order, so that whatever stopped the first run to stop
+				// is what parse() would have met.
+				for(const Run& run:runs)
+				{
+					if(run.thrown)
+						std::rethrow_exception(run.thrown);
+					elements+=run.elements;
+					if(run.failed!=count)
+					{
+						err=run.err;
+						return run.failed;
+					}
+				}
+				return count;
+			}
+			
+			unsigned default_threads(unsigned threads)
+			{
+				return threads ? threads : std::max(std::thread::hardware_concurrency(), 1u);
 			}
 		};
 		
@@ -1037,54 +3027,1057 @@ namespace msgpack11
 	
 	std::istream& operator>>(std::istream& is, MsgPack& msgpack)
 	{
-		msgpack=MsgPackParser::parse_msgpack(is,0);
+		msgpack=MsgPack::parse(is);
 		return is;
 	}
 	
 	MsgPack MsgPack::parse(std::istream& is)
 	{
-		return MsgPackParser::parse_msgpack(is,0);
+		MsgPackParser::StreamSource src(is);
+		return MsgPackParser::Parser(src, ParseOptions()).parse();
+	}
+	
+	MsgPack MsgPack::parse(std::istream& is, std::string &err, const ParseOptions &options)
+	{
+		MsgPackParser::StreamSource src(is);
+		return MsgPackParser::parse_buffer(src, err, options);
+	}
+	
+	MsgPack MsgPack::parse(std::string_view in, std::string &err, const ParseOptions &options)
+	{
+		const uint8_t* cur=reinterpret_cast<const uint8_t*>(in.data());
+		return MsgPackParser::parse_buffer(cur, cur+in.size(), err, options);
+	}
+	
+	MsgPack MsgPack::parse_borrowed(std::string_view in, std::string &err, const ParseOptions &options, std::shared_ptr<const void> owner)
+	{
+		const uint8_t* cur=reinterpret_cast<const uint8_t*>(in.data());
+		MsgPackParser::BorrowNodes src(cur, cur+in.size(), std::move(owner));
+		return MsgPackParser::parse_buffer(src, err, options);
+	}
+	
+	void MsgPack::visit(std::string_view in, MsgPackVisitor &visitor, std::string &err, const ParseOptions &options)
+	{
+		const uint8_t* cur=reinterpret_cast<const uint8_t*>(in.data());
+		MsgPackParser::BufferSource src(cur, cur+in.size());
+		MsgPackParser::VisitorHandler handler(visitor);
+		MsgPackParser::Reader reader(src, handler, options);
+		if(!reader.read())
+			reader.report(err);
+	}
+	
+	// Documented in msgpack.hpp
+	std::vector<MsgPack> MsgPack::parse_multi(const std::string &in,
+		std::string::size_type &parser_stop_pos,
+		std::string &err)
+	{
+		std::vector<MsgPack> msgpack_vec;
+		MessageRange messages(in);
+		parser_stop_pos=0;
+		for(const auto& message:messages)
+		{
+			msgpack_vec.push_back(message.value);
+			parser_stop_pos=message.offset+message.length;
+		}
+		if(!messages.error().empty())
+			err=messages.error();
+		
+		return msgpack_vec;
+	}
+	
+	/* * * * * * * * * * * * * * * * * * * *
+ * Parallel parsing
+ *
+ * A skip pass finds where each value starts, then decode_all() decodes
+ * them on several threads. Whenever the skip pass or a decode fails, the
+ * input is malformed or over a limit, and a sequential parse reports it
+ * exactly as it would have without the threads.
+ */
+	
+	MsgPack MsgPack::parse_parallel(std::string_view in, std::string &err, const ParseOptions &options, unsigned threads)
+	{
+		const uint8_t* const begin=reinterpret_cast<const uint8_t*>(in.data());
+		const uint8_t* const end=begin+std::min(in.size(), options.max_bytes);
+		threads=MsgPackParser::default_threads(threads);
+		size_t const header=begin==end ? 0 : MsgPackParser::token_size(begin, end-begin);
+		bool const is_array=header && ((*begin & 0xf0)==0x90 || *begin==0xdc || *begin==0xdd);
+		if(threads<2 || !is_array || header>static_cast<size_t>(end-begin) || options.max_depth==0)
+			return parse(in, err, options);
+		
+		uint64_t const count=MsgPackParser::members(begin);
+		std::vector<const uint8_t*> bounds;
+		bounds.reserve(std::min<uint64_t>(count, end-begin)+1);
+		const uint8_t* cur=begin+header;
+		for(uint64_t i=0; i<count && cur; ++i)
+		{
+			bounds.push_back(cur);
+			cur=MsgPackParser::skip_value(cur, end);
+		}
+		if(!cur || count>=options.max_elements)
+			return parse(in, err, options);
+		bounds.push_back(cur);
+		
+		// Elements sit one level down.
+		ParseOptions element_options=options;
+		--element_options.max_depth;
+		std::vector<MsgPack> values;
+		std::string element_err;
+		size_t elements=1;
+		if(MsgPackParser::decode_all(bounds, values, element_err, elements, element_options, threads)!=count || elements>options.max_elements)
+			return parse(in, err, options);
+		
+		array result;
+		result.reserve(count);
+		std::move(values.begin(), values.end(), std::back_inserter(result));
+		return MsgPack(std::move(result));
+	}
+	
+	std::vector<MsgPack> MsgPack::parse_multi_parallel(std::string_view in, std::string::size_type &parser_stop_pos, std::string &err, const ParseOptions &options, unsigned threads)
+	{
+		const uint8_t* const begin=reinterpret_cast<const uint8_t*>(in.data());
+		const uint8_t* const end=begin+in.size();
+		std::vector<const uint8_t*> bounds;
+		const uint8_t* cur=begin;
+		while(cur!=end)
+		{
+			const uint8_t* const limit=static_cast<size_t>(end-cur)>options.max_bytes ? cur+options.max_bytes : end;
+			const uint8_t* const next=MsgPackParser::skip_value(cur, limit);
+			if(!next)
+				break;
+			bounds.push_back(cur);
+			cur=next;
+		}
+		bounds.push_back(cur);
+		
+		std::vector<MsgPack> values;
+		size_t elements=0;
+		size_t const parsed=MsgPackParser::decode_all(bounds, values, err, elements, options, MsgPackParser::default_threads(threads));
+		values.resize(parsed);
+		parser_stop_pos=bounds[parsed]-begin;
+		// The skip pass stopped at a message it could not get past; parse
+		// it for the reason.
+		if(parsed==bounds.size()-1 && cur!=end)
+			MsgPackParser::parse_buffer(cur, end, err, options);
+		return values;
+	}
+	
+	/* * * * * * * * * * * * * * * * * * * *
+ * MessageRange
+ */
+	
+	MessageRange::iterator MessageRange::begin()
+	{
+		m_error.clear();
+		m_error_offset=0;
+		return iterator(this, 0);
+	}
+	
+	MessageIterator::MessageIterator(MessageRange *range, size_t offset):m_range(range)
+	{
+		read(offset);
+	}
+	
+	MessageIterator& MessageIterator::operator++()
+	{
+		read(m_message.offset+m_message.length);
+		return *this;
+	}
+	
+	// Decode the message at offset, or become past-the-end.
+	void MessageIterator::read(size_t offset)
+	{
+		std::span<const uint8_t> const in=m_range->m_in;
+		if(offset==in.size())
+		{
+			*this=MessageIterator();
+			return;
+		}
+		const uint8_t* const begin=in.data()+offset;
+		const uint8_t* cur=begin;
+		std::string err;
+		MsgPack value;
+		if(m_range->m_owner)
+		{
+			MsgPackParser::BorrowNodes src(begin, in.data()+in.size(), m_range->m_owner);
+			value=MsgPackParser::parse_buffer(src, err, m_range->m_options);
+			cur=src.position();
+		}
+		else
+		{
+			value=MsgPackParser::parse_buffer(cur, in.data()+in.size(), err, m_range->m_options);
+		}
+		if(!err.empty())
+		{
+			m_range->m_error=std::move(err);
+			m_range->m_error_offset=offset;
+			*this=MessageIterator();
+			return;
+		}
+		m_message={std::move(value), offset, static_cast<size_t>(cur-begin)};
+	}
+	
+	size_t MsgPack::validate(std::span<const uint8_t> in, std::string &err, const ParseOptions &options, size_t count)
+	{
+		const uint8_t* cur=in.data();
+		const uint8_t* const end=in.data()+in.size();
+		if(MsgPackParser::validate(cur, end, count, err, options) && cur!=end)
+			err="trailing data.";
+		return cur-in.data();
+	}
+	
+	size_t MsgPack::validate(std::string_view in, std::string &err, const ParseOptions &options, size_t count)
+	{
+		return validate(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(in.data()), in.size()), err, options, count);
+	}
+	
+	/* * * * * * * * * * * * * * * * * * * *
+ * MsgPackStreamParser
+ */
+	
+	struct MsgPackStreamParser::State
+	{
+		explicit State(const ParseOptions& options):options(options),src(nullptr, nullptr),parser(src, this->options){}
+		
+		using Parser=MsgPackParser::Parser<MsgPackParser::BufferSource>;
+		
+		// Run the parser over [begin, end) until the message completes or
+		// the input runs out. Returns how many bytes were used; a token cut
+		// off at end is not counted.
+		size_t run(const uint8_t* begin, const uint8_t* end)
+		{
+			src=MsgPackParser::BufferSource(begin, end);
+			src.limit(budget);
+			const uint8_t* token=begin;
+			while(token!=end)
+			{
+				Parser::Step const step=parser.step();
+				if(step==Parser::Step::FAILED)
+				{
+					if(!parser.truncated())
+					{
+						parser.report(err);
+						status=Status::FAILED;
+					}
+					break;
+				}
+				token=src.position();
+				if(step==Parser::Step::DONE)
+				{
+					status=Status::COMPLETE;
+					break;
+				}
+			}
+			budget-=token-begin;
+			return token-begin;
+		}
+		
+		// Fail now on a cut-off token that could never fit in the budget,
+		// rather than after buffering all of it.
+		bool pending_fits()
+		{
+			if(pending_size<=budget)
+				return true;
+			err="exceeded maximum size.";
+			status=Status::FAILED;
+			return false;
+		}
+		
+		ParseOptions options;
+		MsgPackParser::BufferSource src;
+		Parser parser;
+		// Bytes the message may still take up.
+		size_t budget=options.max_bytes;
+		// A token cut off at the end of the last feed, and its full size
+		// once its header is in.
+		std::vector<uint8_t> pending;
+		uint64_t pending_size=0;
+		Status status=Status::NEED_MORE;
+		size_t consumed=0;
+		MsgPack value;
+		std::string err;
+	};
+	
+	MsgPackStreamParser::MsgPackStreamParser(const ParseOptions &options):
+		m_state(std::make_unique<State>(options))
+	{
+	}
+	
+	MsgPackStreamParser::MsgPackStreamParser(MsgPackStreamParser &&other) noexcept=default;
+	MsgPackStreamParser& MsgPackStreamParser::operator=(MsgPackStreamParser &&other) noexcept=default;
+	MsgPackStreamParser::~MsgPackStreamParser()=default;
+	
+	MsgPackStreamParser::Status MsgPackStreamParser::feed(const void *data, size_t size)
+	{
+		State& state=*m_state;
+		if(state.status==Status::FAILED)
+			return Status::FAILED;
+		if(state.status==Status::COMPLETE)
+		{
+			state.status=Status::NEED_MORE;
+			state.budget=state.options.max_bytes;
+		}
+		
+		const uint8_t* cur=static_cast<const uint8_t*>(data);
+		const uint8_t* const end=cur+size;
+		if(!state.pending.empty())
+		{
+			// Top up the token set aside last time. Only its header is looked
+			// at again, to learn how long it is.
+			while(!state.pending_size && cur!=end)
+			{
+				state.pending.push_back(*cur++);
+				state.pending_size=MsgPackParser::token_size(state.pending.data(), state.pending.size());
+			}
+			if(!state.pending_fits())
+			{
+				state.consumed=cur-static_cast<const uint8_t*>(data);
+				return Status::FAILED;
+			}
+			size_t const missing=std::min<uint64_t>(state.pending_size-state.pending.size(), end-cur);
+			if(state.pending_size && missing)
+			{
+				state.pending.insert(state.pending.end(), cur, cur+missing);
+				cur+=missing;
+			}
+			if(!state.pending_size || state.pending.size()<state.pending_size)
+			{
+				state.consumed=size;
+				return Status::NEED_MORE;
+			}
+			state.run(state.pending.data(), state.pending.data()+state.pending.size());
+			state.pending.clear();
+			state.pending_size=0;
+		}
+		
+		if(state.status==Status::NEED_MORE)
+		{
+			size_t const used=state.run(cur, end);
+			if(state.status==Status::NEED_MORE)
+			{
+				state.pending.assign(cur+used, end);
+				state.pending_size=MsgPackParser::token_size(state.pending.data(), state.pending.size());
+				cur=end;
+				state.pending_fits();
+			}
+			else
+				cur+=used;
+		}
+		if(state.status==Status::COMPLETE)
+			state.value=state.parser.take();
+		state.consumed=cur-static_cast<const uint8_t*>(data);
+		return state.status;
 	}
 	
-	MsgPack MsgPack::parse(std::istream& is, std::string &err)
+	size_t MsgPackStreamParser::consumed() const
 	{
-		MsgPack ret = MsgPack::parse(is);
-		if (is.eof())
+		return m_state->consumed;
+	}
+	
+	MsgPack MsgPackStreamParser::get()
+	{
+		return std::move(m_state->value);
+	}
+	
+	const std::string& MsgPackStreamParser::error() const
+	{
+		return m_state->err;
+	}
+	
+	/* * * * * * * * * * * * * * * * * * * *
+ * MsgPackView
+ */
+	
+	namespace
+	{
+		const uint8_t nil_byte=0xc0;
+		
+		MsgPack::Type type_of_token(uint8_t first_byte)
 		{
-			err = "end of buffer.";
+			if(first_byte <= 0x7f) return MsgPack::Type::UINT8;
+			if(first_byte >= 0xe0) return MsgPack::Type::INT8;
+			if(first_byte <= 0x8f) return MsgPack::Type::OBJECT;
+			if(first_byte <= 0x9f) return MsgPack::Type::ARRAY;
+			if(first_byte <= 0xbf) return MsgPack::Type::STRING;
+			switch(first_byte)
+			{
+				case 0xc0: return MsgPack::Type::NUL;
+				case 0xc2:
+				case 0xc3: return MsgPack::Type::BOOL;
+				case 0xc4:
+				case 0xc5:
+				case 0xc6: return MsgPack::Type::BINARY;
+				case 0xca: return MsgPack::Type::FLOAT32;
+				case 0xcb: return MsgPack::Type::FLOAT64;
+				case 0xcc: return MsgPack::Type::UINT8;
+				case 0xcd: return MsgPack::Type::UINT16;
+				case 0xce: return MsgPack::Type::UINT32;
+				case 0xcf: return MsgPack::Type::UINT64;
+				case 0xd0: return MsgPack::Type::INT8;
+				case 0xd1: return MsgPack::Type::INT16;
+				case 0xd2: return MsgPack::Type::INT32;
+				case 0xd3: return MsgPack::Type::INT64;
+				case 0xd9:
+				case 0xda:
+				case 0xdb: return MsgPack::Type::STRING;
+				case 0xdc:
+				case 0xdd: return MsgPack::Type::ARRAY;
+				case 0xde:
+				case 0xdf: return MsgPack::Type::OBJECT;
+				case 0xc1: throw std::runtime_error("format error.");
+				default  : return MsgPack::Type::EXTENSION;
+			}
 		}
-		else if (is.fail())
+		
+		// The end of the value at p, throwing if it cannot be found.
+		const uint8_t* skip_or_throw(const uint8_t* p, const uint8_t* end, uint64_t count=1)
 		{
-			err = "format error.";
+			const uint8_t* next=MsgPackParser::skip_value(p, end, count);
+			if(!next)
+				throw std::runtime_error("malformed or truncated value.");
+			return next;
 		}
+		
+		// Read the header of the container at p, returning where its
+		// members start, or throw if it is not a container of that type.
+		const uint8_t* open_container(const uint8_t* p, const uint8_t* end, MsgPack::Type expected, uint64_t& members)
+		{
+			MsgPack::Type const got=type_of_token(*p);
+			if(got!=expected)
+				throw TypeError(expected, got);
+			size_t const available=static_cast<size_t>(end-p);
+			uint64_t const size=MsgPackParser::token_size(p, available);
+			if(!size || size>available)
+				throw std::runtime_error("end of buffer.");
+			members=MsgPackParser::members(p);
+			return p+size;
+		}
+		
+		// Whether the value at p is the string key.
+		bool string_equals(const uint8_t* p, const uint8_t* end, std::string_view key)
+		{
+			if(type_of_token(*p)!=MsgPack::Type::STRING)
+				return false;
+			size_t const available=static_cast<size_t>(end-p);
+			uint64_t const size=MsgPackParser::token_size(p, available);
+			if(!size || size>available)
+				throw std::runtime_error("end of buffer.");
+			size_t const header=*p <= 0xbf ? 1 : *p==0xd9 ? 2 : *p==0xda ? 3 : 5;
+			return size-header==key.size() && std::memcmp(p+header, key.data(), key.size())==0;
+		}
+		
+		/* ViewHandler<T>
+     *
+     * Reader handler that takes one scalar out of a view as T.
+     */
+		template<typename T>
+		struct ViewHandler
+		{
+			MsgPack::Type type;
+			T value{};
+			
+			[[noreturn]] void mismatch() const
+			{
+				if constexpr(std::is_same_v<T, std::string_view>)
+					throw TypeError(MsgPack::Type::STRING, type);
+				else if constexpr(std::is_same_v<T, std::span<const uint8_t>>)
+					throw TypeError(MsgPack::Type::BINARY, type);
+				else
+					throw TypeError(type_of<T>, type);
+			}
+			
+			void boolean(bool v)
+			{
+				if constexpr(scalar_type<T>)
+					value=static_cast<T>(v);
+				else
+					mismatch();
+			}
+			template<typename U>
+			void number(U v)
+			{
+				if constexpr(scalar_type<T>)
+					value=static_cast<T>(v);
+				else
+					mismatch();
+			}
+			void string(std::string_view v)
+			{
+				if constexpr(std::is_same_v<T, std::string_view>)
+					value=v;
+				else
+					mismatch();
+			}
+			void binary(std::span<const uint8_t> v)
+			{
+				if constexpr(std::is_same_v<T, std::span<const uint8_t>>)
+					value=v;
+				else
+					mismatch();
+			}
+			void nil()                                       { mismatch(); }
+			void extension(uint8_t, std::span<const uint8_t>) { mismatch(); }
+			void begin_array(uint32_t)                       { mismatch(); }
+			void begin_map(uint32_t)                         { mismatch(); }
+			void end_array()                                 {}
+			void end_map()                                   {}
+		};
+		
+		const ParseOptions default_options;
+	}
+	
+	MsgPackView::MsgPackView():m_begin(&nil_byte),m_end(&nil_byte+1)
+	{
+	}
+	
+	MsgPackView::MsgPackView(std::span<const uint8_t> bytes):m_begin(bytes.data()),m_end(bytes.data()+bytes.size())
+	{
+	}
+	
+	MsgPackView::MsgPackView(std::string_view bytes):
+		MsgPackView(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size()))
+	{
+	}
+	
+	MsgPack::Type MsgPackView::type() const
+	{
+		if(m_begin==m_end)
+			throw std::runtime_error("end of buffer.");
+		return type_of_token(*m_begin);
+	}
+	
+	template<typename T>
+	T MsgPackView::as() const
+	{
+		ViewHandler<T> handler{type()};
+		MsgPackParser::BufferSource src(m_begin, m_end);
+		MsgPackParser::Reader reader(src, handler, default_options);
+		if(reader.step()==decltype(reader)::Step::FAILED)
+		{
+			std::string err;
+			reader.report(err);
+			throw std::runtime_error(err);
+		}
+		return handler.value;
+	}
+	
+	template MsgPack::int8    MsgPackView::as() const;
+	template MsgPack::int16   MsgPackView::as() const;
+	template MsgPack::int32   MsgPackView::as() const;
+	template MsgPack::int64   MsgPackView::as() const;
+	template MsgPack::uint8   MsgPackView::as() const;
+	template MsgPack::uint16  MsgPackView::as() const;
+	template MsgPack::uint32  MsgPackView::as() const;
+	template MsgPack::uint64  MsgPackView::as() const;
+	template MsgPack::float32 MsgPackView::as() const;
+	template MsgPack::float64 MsgPackView::as() const;
+	template MsgPack::boolean MsgPackView::as() const;
+	template std::string_view MsgPackView::as() const;
+	template std::span<const uint8_t> MsgPackView::as() const;
+	
+	size_t MsgPackView::size() const
+	{
+		MsgPack::Type const t=type();
+		if(t!=MsgPack::Type::ARRAY && t!=MsgPack::Type::OBJECT)
+			return 0;
+		uint64_t members;
+		open_container(m_begin, m_end, t, members);
+		return t==MsgPack::Type::OBJECT ? members/2 : members;
+	}
+	
+	MsgPackView MsgPackView::operator[](size_t i) const
+	{
+		uint64_t members;
+		const uint8_t* p=open_container(m_begin, m_end, MsgPack::Type::ARRAY, members);
+		if(i>=members)
+			return MsgPackView();
+		return MsgPackView(skip_or_throw(p, m_end, i), m_end);
+	}
+	
+	MsgPackView MsgPackView::operator[](std::string_view key) const
+	{
+		uint64_t members;
+		const uint8_t* p=open_container(m_begin, m_end, MsgPack::Type::OBJECT, members);
+		for(; members; members-=2)
+		{
+			if(p==m_end)
+				throw std::runtime_error("end of buffer.");
+			bool const found=string_equals(p, m_end, key);
+			p=skip_or_throw(p, m_end);
+			if(found)
+				return MsgPackView(p, m_end);
+			p=skip_or_throw(p, m_end);
+		}
+		return MsgPackView();
+	}
+	
+	MsgPackView::iterator MsgPackView::begin() const
+	{
+		MsgPack::Type const t=type();
+		if(t!=MsgPack::Type::ARRAY && t!=MsgPack::Type::OBJECT)
+			throw TypeError(MsgPack::Type::ARRAY, t);
+		uint64_t members;
+		const uint8_t* p=open_container(m_begin, m_end, t, members);
+		bool const is_object=t==MsgPack::Type::OBJECT;
+		return iterator(p, m_end, is_object ? members/2 : members, is_object);
+	}
+	
+	MsgPackView::iterator MsgPackView::end() const
+	{
+		return iterator();
+	}
+	
+	std::span<const uint8_t> MsgPackView::bytes() const
+	{
+		return std::span<const uint8_t>(m_begin, skip_or_throw(m_begin, m_end));
+	}
+	
+	MsgPack MsgPackView::to_msgpack() const
+	{
+		std::string err;
+		MsgPack ret=MsgPack::parse(std::string_view(reinterpret_cast<const char*>(m_begin), m_end-m_begin), err);
+		if(!err.empty())
+			throw std::runtime_error(err);
 		return ret;
 	}
 	
-	MsgPack MsgPack::parse(const std::string &in,std::string &err)
+	MsgPackView MsgPackView::iterator::value() const
 	{
-		std::stringstream ss(in);
-		return MsgPack::parse(ss, err);
+		return m_is_object ? MsgPackView(skip_or_throw(m_cur, m_end), m_end) : MsgPackView(m_cur, m_end);
 	}
 	
-	// Documented in msgpack.hpp
-	std::vector<MsgPack> MsgPack::parse_multi(const std::string &in,
-		std::string::size_type &parser_stop_pos,
-		std::string &err)
+	MsgPackView::iterator& MsgPackView::iterator::operator++()
+	{
+		m_cur=skip_or_throw(m_cur, m_end, m_is_object ? 2 : 1);
+		--m_remaining;
+		return *this;
+	}
+	
+	/* * * * * * * * * * * * * * * * * * * *
+ * Path
+ */
+	
+	Path::Path(std::string_view expr, std::string &err)
 	{
-		std::stringstream ss(in);
+		auto const compile=[&]
+		{
+			size_t i=0;
+			while(i<expr.size())
+			{
+				if(expr[i]=='[')
+				{
+					++i;
+					Step step;
+					if(i<expr.size() && expr[i]=='"')
+					{
+						// A quoted key, for keys with dots or brackets in them.
+						for(++i; i<expr.size() && expr[i]!='"'; ++i)
+						{
+							if(expr[i]=='\\' && i+1<expr.size())
+								++i;
+							step.key+=expr[i];
+						}
+						if(i==expr.size())
+							return false;
+						++i;
+					}
+					else
+					{
+						size_t const start=i;
+						for(; i<expr.size() && expr[i]>='0' && expr[i]<='9'; ++i)
+						{
+							if(step.index>(std::numeric_limits<size_t>::max()-9)/10)
+								return false;
+							step.index=step.index*10+(expr[i]-'0');
+						}
+						if(i==start)
+							return false;
+						step.is_index=true;
+					}
+					if(i==expr.size() || expr[i]!=']')
+						return false;
+					++i;
+					m_steps.push_back(std::move(step));
+				}
+				else
+				{
+					if(!m_steps.empty() && expr[i++]!='.')
+						return false;
+					size_t const start=i;
+					while(i<expr.size() && expr[i]!='.' && expr[i]!='[')
+						++i;
+					if(i==start)
+						return false;
+					m_steps.push_back(Step{std::string(expr.substr(start, i-start))});
+				}
+			}
+			return true;
+		};
+		if(!compile())
+		{
+			m_steps.clear();
+			err="invalid path.";
+		}
+	}
+	
+	MsgPackView extract(std::span<const uint8_t> in, const Path &path)
+	{
+		MsgPackView value(in);
+		for(const auto& step:path.m_steps)
+		{
+			value=step.is_index ? value[step.index] : value[std::string_view(step.key)];
+			if(value.is_null())
+				break;
+		}
+		return value;
+	}
+	
+	MsgPackView extract(std::string_view in, const Path &path)
+	{
+		return extract(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(in.data()), in.size()), path);
+	}
+	
+	/* * * * * * * * * * * * * * * * * * * *
+ * Lazy parsing
+ */
+	
+	namespace
+	{
+		MsgPack lazy_msgpack(const std::shared_ptr<const std::string>& buffer, const uint8_t* begin, const uint8_t* end);
+	}
+	
+	/* Lazy<T>
+     *
+     * An array or map from MsgPack::parse_lazy(), kept as the span of the
+     * retained input that encodes it. Its members are decoded the first
+     * time they are reached, one level at a time. Until then, and for as
+     * long as nothing below it changes, it is written back out by copying
+     * that span.
+     */
+	template<typename T>
+	class Lazy final: public Value<T>
+	{
+	public:
+		Lazy(std::shared_ptr<const std::string> buffer, const uint8_t* begin, const uint8_t* end):
+			Value<T>(T()),m_buffer(std::move(buffer)),m_begin(begin),m_end(end){}
 		
-		std::vector<MsgPack> msgpack_vec;
-		while (static_cast<size_t>(ss.tellg()) != in.size() && !ss.eof() && !ss.fail())
+		operator const T&() const override
+		{
+			materialize();
+			return Value<T>::m_value;
+		}
+		operator T&() override
+		{
+			materialize();
+			return Value<T>::m_value;
+		}
+		
+		const MsgPack & operator[](size_t i) const override
+		{
+			if constexpr(std::is_same_v<T,MsgPack::array>)
+				return static_cast<const T&>(*this).at(i);
+			else
+				throw TypeError(MsgPack::Type::ARRAY,type_of<T>);
+		}
+		MsgPack & operator[](size_t i) override
 		{
-			auto next(MsgPack::parse(ss, err));
-			if (!ss.fail())
+			if constexpr(std::is_same_v<T,MsgPack::array>)
+				return static_cast<T&>(*this).at(i);
+			else
+				throw TypeError(MsgPack::Type::ARRAY,type_of<T>);
+		}
+		MsgPack const &operator[](const MsgPack &key) const override
+		{
+			if constexpr(std::is_same_v<T,MsgPack::object>)
+				return static_cast<const T&>(*this).at(key);
+			else
+				throw TypeError(MsgPack::Type::OBJECT,type_of<T>);
+		}
+		MsgPack& operator[](const MsgPack &key) override
+		{
+			if constexpr(std::is_same_v<T,MsgPack::object>)
+				return static_cast<T&>(*this)[key];
+			else
+				throw TypeError(MsgPack::Type::OBJECT,type_of<T>);
+		}
+		
+		// The retained bytes stand in for the value as long as they still
+		// encode it, which cached_size() tells by whether anything below
+		// was mutated.
+		size_t encoded_size(bool& cacheable) const override
+		{
+			if(!m_materialized.load(std::memory_order_acquire))
+				return m_end-m_begin;
+			return this->cached_size(cacheable, [this](bool& subtree)
 			{
-				msgpack_vec.emplace_back(std::move(next));
-				parser_stop_pos = ss.tellg();
+				size_t const size=msgpack11::encoded_size(Value<T>::m_value, subtree, subtree ? this : nullptr);
+				return subtree ? static_cast<size_t>(m_end-m_begin) : size;
+			});
+		}
+		void dump(RawWriter& out) const override
+		{
+			bool pristine=true;
+			encoded_size(pristine);
+			if(pristine)
+				out.write(m_begin, m_end-m_begin);
+			else
+				msgpack11::dump(Value<T>::m_value, out);
+		}
+		
+	private:
+		void materialize() const
+		{
+			std::call_once(m_once, [this]
+			{
+				const_cast<Lazy*>(this)->decode();
+				// A container may already count the retained bytes, so the
+				// members must reach it if they change.
+				this->link_members();
+				m_materialized.store(true, std::memory_order_release);
+			});
+		}
+		
+		// Decode the members, leaving arrays and maps among them lazy. The
+		// bytes were checked by parse_lazy(), so every member is complete.
+		void decode()
+		{
+			T& value=Value<T>::m_value;
+			uint64_t members=MsgPackParser::members(m_begin);
+			const uint8_t* p=m_begin+MsgPackParser::token_size(m_begin, m_end-m_begin);
+			if constexpr(std::is_same_v<T,MsgPack::array>)
+				value.reserve(members);
+			else
+				value.reserve(members/2);
+			MsgPack key;
+			for(uint64_t i=0; i<members; ++i)
+			{
+				const uint8_t* next=MsgPackParser::skip_value(p, m_end);
+				MsgPack member=lazy_msgpack(m_buffer, p, next);
+				if constexpr(std::is_same_v<T,MsgPack::array>)
+					value.push_back(std::move(member));
+				else if(i%2==0)
+					key=std::move(member);
+				else
+					value.emplace(std::move(key), std::move(member));
+				p=next;
 			}
 		}
 		
-		return msgpack_vec;
+		std::shared_ptr<const std::string> m_buffer;
+		const uint8_t* m_begin;
+		const uint8_t* m_end;
+		mutable std::once_flag m_once;
+		mutable std::atomic<bool> m_materialized{false};
+	};
+	
+	namespace
+	{
+		// The value encoded in [begin, end): lazy if it is an array or map.
+		MsgPack lazy_msgpack(const std::shared_ptr<const std::string>& buffer, const uint8_t* begin, const uint8_t* end)
+		{
+			switch(type_of_token(*begin))
+			{
+				case MsgPack::Type::ARRAY:
+					return adopt_msgpack(std::make_shared<Lazy<MsgPack::array>>(buffer, begin, end));
+				case MsgPack::Type::OBJECT:
+					return adopt_msgpack(std::make_shared<Lazy<MsgPack::object>>(buffer, begin, end));
+				default:
+				{
+					// Strings and binaries can point into the retained input.
+					std::string err;
+					MsgPackParser::BorrowNodes src(begin, end, buffer);
+					return MsgPackParser::parse_buffer(src, err, default_options);
+				}
+			}
+		}
+	}
+	
+	MsgPack MsgPack::parse_lazy(std::string in, std::string &err, const ParseOptions &options)
+	{
+		auto const buffer=std::make_shared<const std::string>(std::move(in));
+		const uint8_t* begin=reinterpret_cast<const uint8_t*>(buffer->data());
+		// Check everything now, so that decoding on access cannot fail.
+		const uint8_t* end=begin;
+		MsgPackParser::validate(end, begin+buffer->size(), 1, err, options);
+		if(!err.empty())
+			return MsgPack();
+		return lazy_msgpack(buffer, begin, end);
+	}
+	
+	/* * * * * * * * * * * * * * * * * * * *
+ * Document
+ */
+	
+	struct Document::Arena
+	{
+		explicit Arena(size_t initial_size):resource(initial_size){}
+		// Declared first so that it outlives the finalizers' control blocks.
+		std::pmr::monotonic_buffer_resource resource;
+		std::vector<std::shared_ptr<MsgPackValue>> finalizers;
+	};
+	
+	namespace
+	{
+		const MsgPack empty_document;
+		
+		// First arena chunk, per byte of input. Each value takes about 90
+		// bytes of arena: its slot in the parent's storage and, for
+		// strings, binaries, arrays and maps, a node and its control block.
+		// The benchmark messages need 8 to 13 times their length, which a
+		// chunk of 4 reaches in two growth steps; starting at 1 parsed them
+		// 40% slower, and counting the values first costs a fifth of the
+		// parse. Going higher would reserve more for messages made mostly of
+		// long strings, whose payloads are not in the arena.
+		constexpr size_t arena_bytes_per_input_byte=4;
+	}
+	
+	Document::Document(std::string_view in, std::string &err, const ParseOptions &options):
+		m_arena(std::make_unique<Arena>(std::max<size_t>(1024, in.size()*arena_bytes_per_input_byte))),
+		m_root(&empty_document)
+	{
+		const uint8_t* cur=reinterpret_cast<const uint8_t*>(in.data());
+		MsgPackParser::ArenaNodes<MsgPackParser::BufferSource> src(m_arena->resource, m_arena->finalizers, cur, cur+in.size());
+		MsgPack root=MsgPackParser::parse_buffer(src, err, options);
+		// The root itself lives in the arena too, so that it is never destroyed.
+		m_root=new(m_arena->resource.allocate(sizeof(MsgPack), alignof(MsgPack))) MsgPack(std::move(root));
+	}
+	
+	Document::Document(Document &&other) noexcept:
+		m_arena(std::move(other.m_arena)),
+		m_root(std::exchange(other.m_root, &empty_document))
+	{
+	}
+	
+	Document& Document::operator=(Document &&other) noexcept
+	{
+		if(this!=&other)
+		{
+			release();
+			m_arena=std::move(other.m_arena);
+			m_root=std::exchange(other.m_root, &empty_document);
+		}
+		return *this;
+	}
+	
+	Document::~Document()
+	{
+		release();
+	}
+	
+	// Arrays, objects and control blocks go away with the arena without
+	// being visited. Only the nodes holding heap payloads are destroyed, and
+	// those are leaves, so nothing recurses. A node the tree still refers to
+	// is destroyed in place; one that was dropped during the parse (say, a
+	// duplicate key) is left to its last shared_ptr.
+	void Document::release() noexcept
+	{
+		if(!m_arena)
+			return;
+		for(auto &node:m_arena->finalizers)
+		{
+			if(node.use_count()>1)
+				node->~MsgPackValue();
+		}
+		m_arena.reset();
+		m_root=&empty_document;
+	}
+	
+	/* * * * * * * * * * * * * * * * * * * *
+ * MappedFile
+ */
+	
+	MappedFile::MappedFile(const std::string &path, std::string &err)
+	{
+#ifdef _WIN32
+		(void)path;
+		err="memory-mapped files are not supported on this platform.";
+#else
+		int const fd=::open(path.c_str(), O_RDONLY|O_CLOEXEC);
+		if(fd<0)
+		{
+			err=std::string("cannot open file: ")+std::strerror(errno)+".";
+			return;
+		}
+		struct stat st;
+		if(::fstat(fd, &st)!=0)
+		{
+			err=std::string("cannot open file: ")+std::strerror(errno)+".";
+			::close(fd);
+			return;
+		}
+		// An empty file cannot be mapped, but reads as empty all the same.
+		if(st.st_size>0)
+		{
+			void* const data=::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if(data==MAP_FAILED)
+				err=std::string("cannot map file: ")+std::strerror(errno)+".";
+			else
+			{
+				m_data=static_cast<const uint8_t*>(data);
+				m_size=static_cast<size_t>(st.st_size);
+				::madvise(data, m_size, MADV_SEQUENTIAL);
+			}
+		}
+		::close(fd);
+#endif
+	}
+	
+	MappedFile::MappedFile(MappedFile &&other) noexcept:
+		m_data(std::exchange(other.m_data, nullptr)),
+		m_size(std::exchange(other.m_size, 0))
+	{
+	}
+	
+	MappedFile& MappedFile::operator=(MappedFile &&other) noexcept
+	{
+		if(this!=&other)
+		{
+			unmap();
+			m_data=std::exchange(other.m_data, nullptr);
+			m_size=std::exchange(other.m_size, 0);
+		}
+		return *this;
+	}
+	
+	MappedFile::~MappedFile()
+	{
+		unmap();
+	}
+	
+	void MappedFile::unmap() noexcept
+	{
+#ifndef _WIN32
+		if(m_data)
+			::munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+		m_data=nullptr;
+		m_size=0;
+	}
+	
+	MsgPack MsgPack::parse_file(const std::string &path, std::string &err, const ParseOptions &options, bool borrow)
+	{
+		auto file=std::make_shared<MappedFile>(path, err);
+		if(!err.empty())
+			return MsgPack();
+		if(borrow)
+			return parse_borrowed(file->view(), err, options, file);
+		return parse(file->view(), err, options);
+	}
+	
+	size_t MsgPack::for_each_message(const std::string &path, const std::function<void(const MsgPack&)> &fn, std::string &err, const ParseOptions &options, bool borrow)
+	{
+		auto file=std::make_shared<MappedFile>(path, err);
+		if(!err.empty())
+			return 0;
+		MessageRange messages(file->bytes(), options, borrow ? file : nullptr);
+		size_t count=0;
+		for(const auto& message:messages)
+		{
+			fn(message.value);
+			++count;
+		}
+		if(!messages.error().empty())
+			err=messages.error();
+		return count;
 	}
 	
 	/* * * * * * * * * * * * * * * * * * * *
@@ -1118,7 +4111,7 @@ size_t std::hash<msgpack11::MsgPack>::operator()(const msgpack11::MsgPack &thing
 	{
 	case msgpack11::MsgPack::Type::FLOAT32:
 	case msgpack11::MsgPack::Type::FLOAT64:
-		return std::bit_cast<size_t>(thing.m_ptr->operator ::msgpack11::MsgPack::float64());
+		return std::bit_cast<size_t>(thing.operator ::msgpack11::MsgPack::float64());
 	case msgpack11::MsgPack::Type::NUMBER:
 	case msgpack11::MsgPack::Type::INT:
 	case msgpack11::MsgPack::Type::INT8:
@@ -1130,9 +4123,9 @@ size_t std::hash<msgpack11::MsgPack>::operator()(const msgpack11::MsgPack &thing
 	case msgpack11::MsgPack::Type::UINT32:
 	case msgpack11::MsgPack::Type::UINT64:  
 	case msgpack11::MsgPack::Type::BOOL:
-		return thing.m_ptr->operator ::msgpack11::MsgPack::uint64();
+		return thing.operator ::msgpack11::MsgPack::uint64();
 	case msgpack11::MsgPack::Type::STRING:
-		return std::hash<std::string>()(thing.m_ptr->operator const ::msgpack11::MsgPack::string&());
+		return std::hash<std::string_view>()(thing.as<std::string_view>());
 	case msgpack11::MsgPack::Type::BINARY:
 	case msgpack11::MsgPack::Type::ARRAY:  
 	case msgpack11::MsgPack::Type::OBJECT:
@@ -1,16 +1,26 @@
 #pragma once
 
 #include <string>
-#include <deque>
+#include <string_view>
+#include <span>
 #include <vector>
 #include <tuple>
 #include <unordered_map>
 #include <memory>
+#include <functional>
+#include <memory_resource>
 #include <initializer_list>
+#include <iterator>
 #include <istream>
 #include <ostream>
 #include <sstream>
 #include <concepts>
+#include <type_traits>
+#include <limits>
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
 
 #ifdef _MSC_VER
 #if _MSC_VER <= 1800 // VS 2013
@@ -38,6 +48,76 @@ namespace std
 namespace msgpack11
 {
 	class MsgPackValue;
+	class MsgPackVisitor;
+	class MessageRange;
+	
+	/* Projection
+     *
+     * The map entries a parse keeps; see ParseOptions::keep_keys. Each
+     * path names a key, or a key inside the map under a key, as in
+     * "user.name". An entry whose key is not on any path is skipped
+     * without being decoded. A path that stops at a key keeps all of its
+     * value. Arrays are passed through, so the paths apply to each map in
+     * an array. An empty projection keeps everything.
+     */
+	class Projection final
+	{
+	public:
+		static constexpr size_t npos=std::numeric_limits<size_t>::max();
+		
+		Projection()=default;
+		Projection(std::initializer_list<std::string_view> paths);
+		
+		// Also keep the entry at path.
+		void add(std::string_view path);
+		
+		bool empty() const { return m_nodes.empty(); }
+		
+		// For the parser: the node for key in the map at node, where the
+		// root is node 0. Returns npos if the entry is kept whole and
+		// skip() if it is skipped.
+		size_t find(size_t node, std::string_view key) const;
+		// Keys kept from the map at node.
+		size_t size(size_t node) const { return m_nodes[node].children.size(); }
+		static constexpr size_t skip() { return npos-1; }
+		
+	private:
+		struct Node
+		{
+			std::vector<std::pair<std::string, size_t>> children;
+			bool whole=false;
+		};
+		// The root is added with the first path, so that the projection
+		// every ParseOptions carries costs nothing until it is used.
+		std::vector<Node> m_nodes;
+	};
+	
+	// Limits for parsing untrusted input. A parse that exceeds one fails the
+	// same way malformed input does, with a message saying which.
+	struct ParseOptions
+	{
+		// Nesting of arrays and maps.
+		size_t max_depth=200;
+		// Values in one message, arrays and maps included.
+		size_t max_elements=std::numeric_limits<size_t>::max();
+		// Encoded size of one message.
+		size_t max_bytes=std::numeric_limits<size_t>::max();
+		// Only decode these map entries. Applies to parsing into MsgPack and
+		// to visit(); other entries still count against the limits above.
+		Projection keep_keys;
+	};
+	
+	// Selects the canonical encoding, as in value.dump(Canonical()).
+	struct Canonical {};
+	
+	// Types a string or binary can be read as without copying it.
+	template<typename T>
+	concept view_type=std::same_as<T,std::string_view>||std::same_as<T,std::span<const uint8_t>>;
+	
+	// Types held inline in a MsgPack. __int128 is named explicitly because
+	// std::is_fundamental only covers it in the GNU dialects.
+	template<typename T>
+	concept scalar_type=std::is_fundamental_v<T>||std::same_as<std::remove_cv_t<T>,__int128>;
 	
 	class MsgPack final
 	{
@@ -67,9 +147,11 @@ namespace msgpack11
 			EXTENSION   = 17 << 2
 		};
 		
-		// Array and object typedefs
-		using array=std::deque<MsgPack>;
-		using object=std::unordered_map<MsgPack,MsgPack>;
+		// Array and object typedefs. Their storage comes from a memory
+		// resource, so a Document can place it in its arena; copies always
+		// go back to the default resource.
+		using array=std::pmr::vector<MsgPack>;
+		using object=std::pmr::unordered_map<MsgPack,MsgPack>;
 		using string=std::string;
 		//floats
 		using float32=float;
@@ -113,6 +195,7 @@ namespace msgpack11
 		MsgPack(uint64 value);           // UINT64
 		MsgPack(bool value);               // BOOL
 		MsgPack(const string &value);      // STRING
+		MsgPack(const char * value);       // STRING
 		MsgPack(string &&value);           // STRING
 		MsgPack(const array &values);      // ARRAY
 		MsgPack(array &&values);           // ARRAY
@@ -171,7 +254,7 @@ namespace msgpack11
 		MsgPack(void *) = delete;
 		
 		// Accessors
-		Type type() const;
+		Type type() const { return m_type; }
 		
 		bool is_null()      const { return type() == Type::NUL; }
 		bool is_boolean()   const { return type() == Type::BOOL; }
@@ -197,23 +280,26 @@ namespace msgpack11
 		// distinguish between integer and non-integer numbers - number_value() and int_value()
 		// can both be applied to a NUMBER-typed object.
 		
-		template<typename T> requires(!std::is_const_v<T>)
+		template<typename T> requires(!std::is_const_v<T>&&!view_type<T>)
 		explicit operator T&();
-		template<typename T> requires(!std::is_const_v<T>)
+		template<typename T> requires(!std::is_const_v<T>&&!view_type<T>)
 		T& as(){return operator T&();}
 		
 		// Return the enclosed value if this is a number, throws exception otherwise. Note that msgpack11 does not
 		// distinguish between integer and non-integer numbers - number_value() and int_value()
 		// can both be applied to a NUMBER-typed object.
 		
-		template<typename T> requires(std::is_fundamental_v<T>)
+		// Strings can also be read as std::string_view and binaries as
+		// std::span<const uint8_t>, valid while the value is unchanged.
+		
+		template<typename T> requires(scalar_type<T>||view_type<T>)
 		explicit operator T() const;
-		template<typename T> requires(std::is_fundamental_v<T>)
+		template<typename T> requires(scalar_type<T>||view_type<T>)
 		T as() const{return operator T();}
 		
-		template<typename T> requires(!std::is_fundamental_v<T>)
+		template<typename T> requires(!scalar_type<T>&&!view_type<T>)
 		explicit operator const T&() const;
-		template<typename T> requires(!std::is_fundamental_v<T>)
+		template<typename T> requires(!scalar_type<T>&&!view_type<T>)
 		const T& as() const{return operator const T&();}
 		
 		//cast for immutable types
@@ -230,37 +316,96 @@ namespace msgpack11
 		// Serialize.
 		void dump(std::string &out) const
 		{
-			std::stringstream ss;
-			ss<<*this;
-			out=ss.str();
+			out.clear();
+			dump_to(out);
 		}
 		
 		std::string dump() const
 		{
-			std::stringstream ss;
-			ss<<*this;
-			return ss.str();
+			std::string out;
+			dump_to(out);
+			return out;
+		}
+		
+		// Exact number of bytes dump() produces. Arrays and objects cache their
+		// size until a mutable reference into them or their members is taken.
+		size_t encoded_size() const;
+		
+		// Serialize by appending to out. Clear out before each call to reuse
+		// its capacity across messages.
+		void dump_to(std::string &out) const;
+		void dump_to(binary &out) const;
+		
+		// Serialize with map entries in order of their encoded keys, compared
+		// byte by byte, and every integer and length in its smallest
+		// encoding, whatever the input they were parsed from used. Values
+		// that differ only in map order or integer width encode the same.
+		// Floats keep their width and are never written as integers, so
+		// MsgPack(1), MsgPack(1.0) and MsgPack(1.0f) encode differently
+		// even though they compare equal. An array or object outside a Document
+		// keeps the bytes until something in it changes, and hands them out
+		// again when this is repeated on it; the values inside keep nothing.
+		std::string dump(Canonical) const
+		{
+			std::string out;
+			dump_to(out, Canonical());
+			return out;
 		}
+		void dump_to(std::string &out, Canonical) const;
+		
+		// A 64-bit hash of dump(Canonical()): values with the same canonical
+		// encoding get the same fingerprint.
+		uint64_t fingerprint() const;
 		
 		friend std::ostream& operator<<(std::ostream& os, const MsgPack& msgpack);
 		// Parse. If parse fails, set msgpack to MsgPack() and
 		// sets failbit on stream.
 		friend std::istream& operator>>(std::istream& is, MsgPack& msgpack);
 		
-		// Parse. If parse fails, return MsgPack() and assign
-		// an error message to err.
-		static MsgPack parse(const std::string & in, std::string & err);
+		// Parse directly from a contiguous buffer. If parse fails, return
+		// MsgPack() and assign an error message to err.
+		static MsgPack parse(std::string_view in, std::string & err, const ParseOptions &options = {});
 		// Parse. If parse fails, return MsgPack(), sets failbit on stream and and
 		// assign an error message to err.
-		static MsgPack parse(std::istream& is, std::string &err);
+		static MsgPack parse(std::istream& is, std::string &err, const ParseOptions &options = {});
 		// Parse (without the need to default initialise object first).
 		// If parse fails, return MsgPack() and sets failbit on stream.
 		static MsgPack parse(std::istream& is);
+		// Parse with strings and binaries pointing into in instead of holding
+		// copies of it. Each is copied only once something asks for it as a
+		// std::string or binary reference, as a mutation does; reading it as
+		// a view never copies. in must outlive the result, unless owner is
+		// given, in which case every value still pointing into in holds it.
+		static MsgPack parse_borrowed(std::string_view in, std::string &err, const ParseOptions &options = {}, std::shared_ptr<const void> owner = nullptr);
+		// Parse the file at path through a MappedFile, with no copy of it in
+		// between. If borrow, strings and binaries point into the mapping as
+		// with parse_borrowed(), keeping it mapped while any of them does.
+		static MsgPack parse_file(const std::string &path, std::string &err, const ParseOptions &options = {}, bool borrow = false);
+		// Call fn with each of the concatenated messages in the file at path,
+		// decoding one at a time from a MappedFile. Returns how many were
+		// read; if one is malformed, stops there and assigns an error message
+		// to err. borrow is as for parse_file().
+		static size_t for_each_message(const std::string &path, const std::function<void(const MsgPack&)> &fn, std::string &err, const ParseOptions &options = {}, bool borrow = false);
+		// Check that in is exactly count well-formed values, or any number
+		// of them if count is 0, each within options. Nothing is built.
+		// Returns the offset just past them; on failure, returns the offset
+		// of the value at fault and assigns an error message to err, which
+		// is "trailing data." if bytes are left after count values.
+		static size_t validate(std::span<const uint8_t> in, std::string &err, const ParseOptions &options = {}, size_t count = 1);
+		static size_t validate(std::string_view in, std::string &err, const ParseOptions &options = {}, size_t count = 1);
+		// Parse, keeping in to decode arrays and maps from only when they are
+		// first accessed. Until something in one changes, dumping it copies
+		// its original bytes. The whole input is still checked up front.
+		static MsgPack parse_lazy(std::string in, std::string &err, const ParseOptions &options = {});
+		// Report the value in as events to visitor, without building it. If
+		// in is malformed, the events before the error have already been
+		// reported when an error message is assigned to err.
+		static void visit(std::string_view in, MsgPackVisitor &visitor, std::string &err, const ParseOptions &options = {});
 		static MsgPack parse(const char * in, size_t len, std::string & err)
 		{
 			if (in)
 			{
-				return parse(std::string(in,in+len),err);
+				return parse(std::string_view(in,len),err);
 			}
 			else
 			{
@@ -268,7 +413,8 @@ namespace msgpack11
 				return nullptr;
 			}
 		}
-		// Parse multiple objects, concatenated or separated by whitespace
+		// Parse multiple objects, concatenated. parser_stop_pos is set past the
+		// last one parsed. Use MessageRange to take them one at a time.
 		static std::vector<MsgPack> parse_multi(
 			const std::string & in,
 			std::string::size_type & parser_stop_pos,
@@ -282,6 +428,14 @@ namespace msgpack11
 			return parse_multi(in, parser_stop_pos, err);
 		}
 		
+		// Parallel versions of parse() and parse_multi(), with the same
+		// results. A skip pass finds where each element of a top-level array,
+		// or each message, starts; they are then decoded on up to threads
+		// threads, or one per core if threads is 0. Anything but an array is
+		// parsed sequentially.
+		static MsgPack parse_parallel(std::string_view in, std::string &err, const ParseOptions &options = {}, unsigned threads = 0);
+		static std::vector<MsgPack> parse_multi_parallel(std::string_view in, std::string::size_type &parser_stop_pos, std::string &err, const ParseOptions &options = {}, unsigned threads = 0);
+		
 		bool operator== (const MsgPack &rhs) const;
 		std::partial_ordering operator<=>(const MsgPack &rhs) const;
 		
@@ -300,8 +454,506 @@ namespace msgpack11
 		bool has_shape(const shape & types, std::string & err) const;
 		
 	private:
+		template<typename F>
+		auto visit_scalar(F&& visitor) const;
+		friend MsgPack adopt_msgpack(std::shared_ptr<MsgPackValue> node);
+		friend size_t size_msgpack(const MsgPack &msgpack, bool &cacheable);
+		friend const MsgPackValue* value_of(const MsgPack &msgpack);
+		template<typename Writer>
+		friend void dump_msgpack(const MsgPack &msgpack, Writer &out);
+		friend void canonical_msgpack(const MsgPack &msgpack, std::string &out, bool &cacheable);
+		
+		// The type tag and scalar payloads live inline; only strings, binaries,
+		// arrays, objects and extensions are held on the heap through m_ptr.
+		Type m_type;
+		union
+		{
+			boolean m_boolean;
+			float32 m_float32;
+			float64 m_float64;
+			int8    m_int8;
+			int16   m_int16;
+			int32   m_int32;
+			int64   m_int64;
+			uint8   m_uint8;
+			uint16  m_uint16;
+			uint32  m_uint32;
+			uint64  m_uint64;
+		};
 		std::shared_ptr<MsgPackValue> m_ptr;
 		friend struct std::hash<MsgPack>;
 	};
 	
+	/* MsgPackVisitor
+     *
+     * Receives a value from MsgPack::visit() as a sequence of events. Each
+     * begin_array(n) is followed by n values and then end_array(); each
+     * begin_map(n) by n keys, each followed by its value, and then
+     * end_map(). Strings, binaries and extension payloads point into the
+     * input and are only valid during the call. Unhandled events are
+     * ignored. Under ParseOptions::keep_keys, skipped entries report no
+     * events and n is only an upper bound.
+     */
+	class MsgPackVisitor
+	{
+	public:
+		virtual ~MsgPackVisitor()=default;
+		
+		virtual void on_nil() {}
+		virtual void on_bool(bool) {}
+		virtual void on_int(int64_t) {}
+		virtual void on_uint(uint64_t) {}
+		virtual void on_float(double) {}
+		virtual void on_str(std::string_view) {}
+		virtual void on_bin(std::span<const uint8_t>) {}
+		virtual void on_ext(uint8_t, std::span<const uint8_t>) {}
+		virtual void begin_array(uint32_t) {}
+		virtual void end_array() {}
+		virtual void begin_map(uint32_t) {}
+		virtual void end_map() {}
+	};
+	
+	/* Packer
+     *
+     * Encodes values straight into the end of a buffer, with the encodings
+     * MsgPack::dump() picks, without building a MsgPack first. An array is
+     * begin_array(n) followed by its n values and a map begin_map(n)
+     * followed by n keys, each followed by its value. The counts are not
+     * checked; packing fewer or more values than declared gives malformed
+     * output.
+     *
+     * When the count is not known up front, begin_array() or begin_map()
+     * without one writes a 32-bit header, and the matching end_array() or
+     * end_map() fills it in from the values packed since. With compact
+     * set, the contents are moved down so that the header takes no more
+     * bytes than dump() would give it, which costs a copy of them.
+     */
+	class Packer final
+	{
+	public:
+		explicit Packer(std::string &out):m_string(&out){}
+		explicit Packer(MsgPack::binary &out):m_binary(&out){}
+		
+		Packer& pack_nil();
+		Packer& pack_bool(bool value);
+		Packer& pack_int(int64_t value);
+		Packer& pack_uint(uint64_t value);
+		Packer& pack_float(float value);
+		Packer& pack_double(double value);
+		Packer& pack_str(std::string_view value);
+		Packer& pack_bin(std::span<const uint8_t> value);
+		Packer& pack_ext(uint8_t type, std::span<const uint8_t> data);
+		Packer& begin_array(uint32_t size);
+		Packer& begin_map(uint32_t size);
+		Packer& begin_array();
+		Packer& begin_map();
+		// Close the innermost begin_array() or begin_map() without a count.
+		// Throws std::runtime_error if that is not what is open, or if a
+		// map has a key without a value.
+		Packer& end_array(bool compact=false);
+		Packer& end_map(bool compact=false);
+		// A value that has already been built.
+		Packer& pack(const MsgPack &value);
+		
+		// Numbers by their C++ type, in the smallest encoding that holds the
+		// value, as MsgPack does.
+		template<typename T> requires std::is_arithmetic_v<T>
+		Packer& pack(T value)
+		{
+			if constexpr(std::is_same_v<T,bool>)
+				return pack_bool(value);
+			else if constexpr(std::is_same_v<T,float>)
+				return pack_float(value);
+			else if constexpr(std::is_floating_point_v<T>)
+				return pack_double(static_cast<double>(value));
+			else if constexpr(std::is_signed_v<T>)
+				return pack_int(value);
+			else
+				return pack_uint(value);
+		}
+		
+	private:
+		// Append n bytes to the buffer and return where they start.
+		uint8_t* grow(size_t n);
+		size_t position() const { return m_string ? m_string->size() : m_binary->size(); }
+		template<typename T>
+		Packer& emit(const T &value);
+		Packer& end(bool is_map, bool compact);
+		void completed();
+		
+		// A container still being packed. Once one without a count is open,
+		// those inside it are tracked as well, so that each of its values
+		// is counted once. With a count, values is how many are still to
+		// come; without, how many came so far and offset is its header.
+		struct Open
+		{
+			uint64_t values;
+			size_t offset;
+			bool is_map;
+			bool counted;
+		};
+		
+		std::string *m_string=nullptr;
+		MsgPack::binary *m_binary=nullptr;
+		std::vector<Open> m_open;
+	};
+	
+#ifndef _WIN32
+	/* GatherDump
+     *
+     * A value encoded as a list of buffers for writev() or sendmsg(), so
+     * that large strings, binaries and extension payloads are sent from
+     * where the value holds them instead of being copied. Headers and
+     * whatever is smaller than min_reference bytes are encoded into a
+     * scratch buffer the GatherDump owns. The value is kept alive, but
+     * must not be changed while iov() is in use.
+     */
+	class GatherDump final
+	{
+	public:
+		explicit GatherDump(const MsgPack &value, size_t min_reference=4096);
+		GatherDump(GatherDump&&)=default;
+		GatherDump& operator=(GatherDump&&)=default;
+		GatherDump(const GatherDump&)=delete;
+		GatherDump& operator=(const GatherDump&)=delete;
+		
+		const std::vector<iovec>& iov() const { return m_iov; }
+		// Total bytes across iov().
+		size_t size() const { return m_size; }
+		
+	private:
+		// A run of scratch bytes, if data is null, or a payload in place.
+		struct Piece
+		{
+			const void *data;
+			size_t offset;
+			size_t size;
+		};
+		void append(const MsgPack &value, size_t min_reference, std::vector<Piece> &pieces);
+		void append(const void *data, size_t size, size_t min_reference, std::vector<Piece> &pieces);
+		uint8_t* grow(size_t n, std::vector<Piece> &pieces);
+		
+		MsgPack m_value;
+		std::vector<uint8_t> m_scratch;
+		std::vector<iovec> m_iov;
+		size_t m_size=0;
+	};
+#endif
+	
+	/* MsgPackView
+     *
+     * A read-only view of one encoded value that answers queries by walking
+     * the bytes in place. Finding an element or a key skips the values in
+     * front of it by their length headers, without decoding them. Nothing
+     * is checked up front: an accessor that runs into malformed or
+     * truncated bytes throws std::runtime_error. The bytes must outlive the
+     * view.
+     */
+	class MsgPackView final
+	{
+	public:
+		class iterator;
+		
+		// A nil value.
+		MsgPackView();
+		// The value at the start of bytes; anything after it is ignored.
+		explicit MsgPackView(std::span<const uint8_t> bytes);
+		explicit MsgPackView(std::string_view bytes);
+		
+		MsgPack::Type type() const;
+		
+		bool is_null()      const { return type() == MsgPack::Type::NUL; }
+		bool is_boolean()   const { return type() == MsgPack::Type::BOOL; }
+		bool is_number()    const { return static_cast<uint8_t>(type())&static_cast<uint8_t>(MsgPack::Type::NUMBER); }
+		bool is_string()    const { return type() == MsgPack::Type::STRING; }
+		bool is_binary()    const { return type() == MsgPack::Type::BINARY; }
+		bool is_array()     const { return type() == MsgPack::Type::ARRAY; }
+		bool is_object()    const { return type() == MsgPack::Type::OBJECT; }
+		bool is_extension() const { return type() == MsgPack::Type::EXTENSION; }
+		
+		// Numbers and booleans convert as with MsgPack::as<T>(). Strings can
+		// also be read as std::string_view and binaries as
+		// std::span<const uint8_t>, both pointing into the bytes.
+		template<typename T>
+		T as() const;
+		
+		// Number of elements of an array or entries of a map, 0 otherwise.
+		size_t size() const;
+		// Element i of an array, or nil if out of range.
+		MsgPackView operator[](size_t i) const;
+		// The value of the string key in a map, or nil if absent.
+		MsgPackView operator[](std::string_view key) const;
+		
+		// Iterate the elements of an array, or the keys of a map with
+		// iterator::value() giving the value of each.
+		iterator begin() const;
+		iterator end() const;
+		
+		// The encoded value.
+		std::span<const uint8_t> bytes() const;
+		// Decode the value; this also makes a view convertible to MsgPack.
+		MsgPack to_msgpack() const;
+		
+	private:
+		MsgPackView(const uint8_t *begin, const uint8_t *end):m_begin(begin),m_end(end){}
+		
+		// The value starts at m_begin; m_end bounds the bytes it may use.
+		const uint8_t *m_begin;
+		const uint8_t *m_end;
+	};
+	
+	class MsgPackView::iterator
+	{
+	public:
+		using iterator_category=std::forward_iterator_tag;
+		using value_type=MsgPackView;
+		using difference_type=std::ptrdiff_t;
+		using pointer=void;
+		using reference=MsgPackView;
+		
+		iterator()=default;
+		
+		MsgPackView operator*() const { return MsgPackView(m_cur, m_end); }
+		MsgPackView value() const;
+		iterator& operator++();
+		iterator operator++(int)
+		{
+			iterator old=*this;
+			++*this;
+			return old;
+		}
+		// Only meaningful between iterators of the same container.
+		bool operator==(const iterator &other) const { return m_remaining==other.m_remaining; }
+		
+	private:
+		friend class MsgPackView;
+		iterator(const uint8_t *cur, const uint8_t *end, uint64_t remaining, bool is_object):
+			m_cur(cur),m_end(end),m_remaining(remaining),m_is_object(is_object){}
+		
+		const uint8_t *m_cur=nullptr;
+		const uint8_t *m_end=nullptr;
+		uint64_t m_remaining=0;
+		bool m_is_object=false;
+	};
+	
+	/* Path
+     *
+     * A compiled path to a value nested in maps and arrays, such as
+     * "a.b[3].c": map keys separated by dots and array indices in
+     * brackets. Keys holding dots or brackets can be quoted, as in
+     * a["b.c"], with a backslash escaping the next character. The empty
+     * path is the value itself.
+     */
+	class Path final
+	{
+	public:
+		// Compile expr. If it is malformed, the path is empty and an error
+		// message is assigned to err.
+		Path(std::string_view expr, std::string &err);
+		
+		size_t size() const { return m_steps.size(); }
+		
+	private:
+		friend MsgPackView extract(std::span<const uint8_t> in, const Path &path);
+		
+		struct Step
+		{
+			std::string key;
+			size_t index=0;
+			bool is_index=false;
+		};
+		std::vector<Step> m_steps;
+	};
+	
+	// The value at path in the encoded value at the start of in, found by
+	// walking the bytes as MsgPackView does: siblings in front of each step
+	// are skipped without being decoded. A missing key or index, or a nil
+	// on the way, gives a nil view; stepping into a value of the wrong type
+	// throws std::runtime_error. to_msgpack() decodes the result.
+	MsgPackView extract(std::span<const uint8_t> in, const Path &path);
+	MsgPackView extract(std::string_view in, const Path &path);
+	
+	/* MessageIterator
+     *
+     * Walks a MessageRange, decoding the message it stands on when it gets
+     * there. Past-the-end once it leaves the last message or reaches one
+     * that fails to parse.
+     */
+	class MessageIterator
+	{
+	public:
+		// A message with the span of the buffer that encodes it.
+		struct Message
+		{
+			MsgPack value;
+			size_t offset=0;
+			size_t length=0;
+		};
+		
+		using iterator_category=std::forward_iterator_tag;
+		using value_type=Message;
+		using difference_type=std::ptrdiff_t;
+		using pointer=const Message*;
+		using reference=const Message&;
+		
+		MessageIterator()=default;
+		
+		const Message& operator*() const { return m_message; }
+		const Message* operator->() const { return &m_message; }
+		MessageIterator& operator++();
+		MessageIterator operator++(int)
+		{
+			MessageIterator old=*this;
+			++*this;
+			return old;
+		}
+		bool operator==(const MessageIterator &other) const
+		{
+			return m_range==other.m_range && (!m_range || m_message.offset==other.m_message.offset);
+		}
+		
+	private:
+		friend class MessageRange;
+		MessageIterator(MessageRange *range, size_t offset);
+		void read(size_t offset);
+		
+		MessageRange *m_range=nullptr;
+		Message m_message;
+	};
+	
+	/* MessageRange
+     *
+     * The messages in a buffer of concatenated MessagePack values, decoded
+     * one at a time as the range is iterated, so only the current one is
+     * held. The buffer is read in place and must outlive the range. If
+     * owner is given, strings and binaries point into the buffer, each
+     * holding owner, as with MsgPack::parse_borrowed(). Iteration stops
+     * early at a message that fails to parse; error() and error_offset()
+     * then say why and where.
+     */
+	class MessageRange final
+	{
+	public:
+		using iterator=MessageIterator;
+		
+		explicit MessageRange(std::span<const uint8_t> in, const ParseOptions &options = {}, std::shared_ptr<const void> owner = nullptr):
+			m_in(in),m_options(options),m_owner(std::move(owner)){}
+		explicit MessageRange(std::string_view in, const ParseOptions &options = {}, std::shared_ptr<const void> owner = nullptr):
+			MessageRange(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(in.data()), in.size()), options, std::move(owner)){}
+		
+		iterator begin();
+		iterator end() const { return iterator(); }
+		
+		// Empty unless the last iteration stopped at a malformed message.
+		const std::string& error() const { return m_error; }
+		// Offset of that message.
+		size_t error_offset() const { return m_error_offset; }
+		
+	private:
+		friend class MessageIterator;
+		
+		std::span<const uint8_t> m_in;
+		ParseOptions m_options;
+		std::shared_ptr<const void> m_owner;
+		std::string m_error;
+		size_t m_error_offset=0;
+	};
+	
+	/* MsgPackStreamParser
+     *
+     * Parses a message that arrives in pieces, e.g. from a socket. Each
+     * call to feed() carries on from where the last one stopped, so every
+     * byte is decoded once however the message is split. A value cut off
+     * at the end of a piece is set aside and completed from the next one.
+     */
+	class MsgPackStreamParser final
+	{
+	public:
+		enum class Status { NEED_MORE, COMPLETE, FAILED };
+		
+		explicit MsgPackStreamParser(const ParseOptions &options = {});
+		MsgPackStreamParser(MsgPackStreamParser &&other) noexcept;
+		MsgPackStreamParser& operator=(MsgPackStreamParser &&other) noexcept;
+		~MsgPackStreamParser();
+		
+		// Consume size bytes of data. Returns COMPLETE once a whole message
+		// has been read, leaving any bytes of data past its end unconsumed
+		// (see consumed()); feeding again starts on the next message. A
+		// FAILED parser stays failed, with the reason in error().
+		Status feed(const void *data, size_t size);
+		
+		// Bytes of data the last feed() consumed.
+		size_t consumed() const;
+		// The message completed by the last feed().
+		MsgPack get();
+		const std::string& error() const;
+		
+	private:
+		struct State;
+		std::unique_ptr<State> m_state;
+	};
+	
+	/* Document
+     *
+     * A parsed message whose values and array and map storage are
+     * allocated from one monotonic arena. Strings too long for the
+     * small-string buffer, binaries and extensions keep their payload on
+     * the heap. Destroying the Document frees just those payloads and
+     * releases the arena's chunks instead of walking the tree. Everything
+     * reached through root(), including copies of its values, shares that
+     * storage and must not outlive the Document.
+     */
+	class Document final
+	{
+	public:
+		// Parse in. If parse fails, root() is MsgPack() and an error message
+		// is assigned to err.
+		Document(std::string_view in, std::string &err, const ParseOptions &options = {});
+		Document(Document &&other) noexcept;
+		Document& operator=(Document &&other) noexcept;
+		Document(const Document&)=delete;
+		Document& operator=(const Document&)=delete;
+		~Document();
+		
+		const MsgPack& root() const { return *m_root; }
+		
+	private:
+		struct Arena;
+		void release() noexcept;
+		
+		std::unique_ptr<Arena> m_arena;
+		const MsgPack *m_root;
+	};
+	
+	/* MappedFile
+     *
+     * A file mapped read-only into memory and advised for sequential
+     * access, so that it can be parsed in place: the kernel pages it in
+     * ahead of the parser and may drop pages behind it, instead of the
+     * whole file being read into a buffer first. The mapping lasts as long
+     * as the MappedFile.
+     */
+	class MappedFile final
+	{
+	public:
+		// Map the file at path. If that fails, bytes() is empty and an error
+		// message is assigned to err.
+		MappedFile(const std::string &path, std::string &err);
+		MappedFile(MappedFile &&other) noexcept;
+		MappedFile& operator=(MappedFile &&other) noexcept;
+		MappedFile(const MappedFile&)=delete;
+		MappedFile& operator=(const MappedFile&)=delete;
+		~MappedFile();
+		
+		std::span<const uint8_t> bytes() const { return {m_data, m_size}; }
+		std::string_view view() const { return {reinterpret_cast<const char*>(m_data), m_size}; }
+		size_t size() const { return m_size; }
+		
+	private:
+		void unmap() noexcept;
+		
+		const uint8_t *m_data=nullptr;
+		size_t m_size=0;
+	};
+	
 } // namespace msgpack11
@@ -17,7 +17,7 @@ TEST(MSGPACK_ARRAY, pack_unpack_fixarray)
     msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(dumped, err) };
     EXPECT_TRUE(parsed.is_array());
 
-    msgpack11::MsgPack::array v2 = parsed.array_items();
+    msgpack11::MsgPack::array v2 = parsed.as<msgpack11::MsgPack::array>();
     msgpack11::MsgPack packed2{v2};
 
     EXPECT_TRUE(v1 == v2);
@@ -37,7 +37,7 @@ TEST(MSGPACK_ARRAY, pack_unpack_array16_l)
     msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(dumped, err) };
     EXPECT_TRUE(parsed.is_array());
 
-    msgpack11::MsgPack::array v2 = parsed.array_items();
+    msgpack11::MsgPack::array v2 = parsed.as<msgpack11::MsgPack::array>();
     EXPECT_TRUE(v1 == v2);
 }
 
@@ -55,7 +55,7 @@ TEST(MSGPACK_ARRAY, pack_unpack_array16_h)
     msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(dumped, err) };
     EXPECT_TRUE(parsed.is_array());
 
-    msgpack11::MsgPack::array v2 = parsed.array_items();
+    msgpack11::MsgPack::array v2 = parsed.as<msgpack11::MsgPack::array>();
     EXPECT_TRUE(v1 == v2);
 }
 
@@ -75,7 +75,7 @@ TEST(MSGPACK_ARRAY, pack_unpack_array32_l)
     msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(dumped, err) };
     EXPECT_TRUE(parsed.is_array());
 
-    msgpack11::MsgPack::array v2 = parsed.array_items();
+    msgpack11::MsgPack::array v2 = parsed.as<msgpack11::MsgPack::array>();
     EXPECT_TRUE(v1 == v2);
 }
 
@@ -87,18 +87,15 @@ TEST(MSGPACK_ARRAY, pack_unpack_object_array)
     std::string dumped{packed.dump()};
     EXPECT_EQ(static_cast<uint8_t>(dumped[0]), 0x9fu);
     EXPECT_EQ(static_cast<uint8_t>(dumped[1]), 0x82u);
-    EXPECT_EQ(static_cast<uint8_t>(dumped[2]), 0xa1u);
-    EXPECT_EQ(static_cast<uint8_t>(dumped[3]), 'a');
-    EXPECT_EQ(static_cast<uint8_t>(dumped[4]), 0x64u);
-    EXPECT_EQ(static_cast<uint8_t>(dumped[5]), 0xa1u);
-    EXPECT_EQ(static_cast<uint8_t>(dumped[6]), 'b');
-    EXPECT_EQ(static_cast<uint8_t>(dumped[7]), 0xccu);
-    EXPECT_EQ(static_cast<uint8_t>(dumped[8]), 0xc8u);
+    // MsgPack::object is unordered, so only the encoding of each entry is fixed.
+    EXPECT_EQ(dumped.size(), 1u + 0x0f * 8u);
+    EXPECT_NE(dumped.find("\xa1" "a" "\x64", 2), std::string::npos);
+    EXPECT_NE(dumped.find("\xa1" "b" "\xcc\xc8", 2), std::string::npos);
 
     std::string err;
     msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(dumped, err) };
     EXPECT_TRUE(parsed.is_array());
 
-    msgpack11::MsgPack::array v2 = parsed.array_items();
+    msgpack11::MsgPack::array v2 = parsed.as<msgpack11::MsgPack::array>();
     EXPECT_TRUE(v1 == v2);
 }
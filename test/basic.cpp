@@ -26,7 +26,7 @@ const unsigned int kLoop = 10000;
 const unsigned int kElements = 100;
 const double kEPS = 1e-10;
 
-#define GEN_TEST(test_type,get_value_func)                                              \
+#define GEN_TEST(test_type)                                                             \
     do {                                                                                \
         vector<test_type> v;                                                            \
         v.push_back(0);                                                                 \
@@ -41,48 +41,48 @@ const double kEPS = 1e-10;
             msgpack11::MsgPack packed{val1};                                            \
             std::string err;                                                            \
             msgpack11::MsgPack parsed = msgpack11::MsgPack::parse(packed.dump(), err ); \
-            EXPECT_EQ(val1, parsed.get_value_func());                                   \
+            EXPECT_EQ(val1, std::as_const(parsed).as<test_type>());                               \
         }                                                                               \
     } while(0)
 
 TEST(MSGPACK, simple_buffer_uint8)
 {
-    GEN_TEST(uint8_t, uint8_value);
+    GEN_TEST(uint8_t);
 }
 
 TEST(MSGPACK, simple_buffer_uint16)
 {
-    GEN_TEST(uint16_t, uint16_value);
+    GEN_TEST(uint16_t);
 }
 
 TEST(MSGPACK, simple_buffer_uint32)
 {
-    GEN_TEST(uint32_t, uint32_value);
+    GEN_TEST(uint32_t);
 }
 
 TEST(MSGPACK, simple_buffer_uint64)
 {
-    GEN_TEST(uint64_t, uint64_value);
+    GEN_TEST(uint64_t);
 }
 
 TEST(MSGPACK, simple_buffer_int8)
 {
-    GEN_TEST(int8_t, int8_value);
+    GEN_TEST(int8_t);
 }
 
 TEST(MSGPACK, simple_buffer_int16)
 {
-    GEN_TEST(int16_t, int16_value);
+    GEN_TEST(int16_t);
 }
 
 TEST(MSGPACK, simple_buffer_int32)
 {
-    GEN_TEST(int32_t, int32_value);
+    GEN_TEST(int32_t);
 }
 
 TEST(MSGPACK, simple_buffer_int64)
 {
-    GEN_TEST(int64_t, int64_value);
+    GEN_TEST(int64_t);
 }
 
 #if !defined(_MSC_VER) || _MSC_VER >=1800
@@ -117,7 +117,7 @@ TEST(MSGPACK, simple_buffer_float)
         msgpack11::MsgPack packed{val1};
         std::string err;
         msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(packed.dump(), err ) };
-        float val2 = parsed.float32_value();
+        float val2 = std::as_const(parsed).as<msgpack11::MsgPack::float32>();
 
         if (std::isnan(val1))
             EXPECT_TRUE(std::isnan(val2));
@@ -140,11 +140,11 @@ struct TypePair {
 template<typename F> struct ValueTypeTraits {};
 template<> struct ValueTypeTraits<float> {
     using func_ptr_type = float (msgpack11::MsgPack::*)() const;
-    static func_ptr_type constexpr value = &msgpack11::MsgPack::float32_value;
+    static func_ptr_type constexpr value = &msgpack11::MsgPack::as<msgpack11::MsgPack::float32>;
 };
 template<> struct ValueTypeTraits<double> {
     using func_ptr_type = double (msgpack11::MsgPack::*)() const;
-    static func_ptr_type constexpr value = &msgpack11::MsgPack::float64_value;
+    static func_ptr_type constexpr value = &msgpack11::MsgPack::as<msgpack11::MsgPack::float64>;
 };
 } // namespace
 
@@ -222,7 +222,7 @@ TEST(MSGPACK, simple_buffer_double)
         msgpack11::MsgPack packed{val1};
         std::string err;
         msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(packed.dump(), err ) };
-        double val2 = parsed.float64_value();
+        double val2 = std::as_const(parsed).as<msgpack11::MsgPack::float64>();
 
         if (std::isnan(val1))
             EXPECT_TRUE(std::isnan(val2));
@@ -249,7 +249,7 @@ TEST(MSGPACK, simple_buffer_true)
     msgpack11::MsgPack packed{val1};
     std::string err;
     msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(packed.dump(), err ) };
-    bool val2 = parsed.bool_value();
+    bool val2 = std::as_const(parsed).as<msgpack11::MsgPack::boolean>();
     EXPECT_EQ(val1, val2);
 }
 
@@ -259,7 +259,7 @@ TEST(MSGPACK, simple_buffer_false)
     msgpack11::MsgPack packed{val1};
     std::string err;
     msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(packed.dump(), err ) };
-    bool val2 = parsed.bool_value();
+    bool val2 = std::as_const(parsed).as<msgpack11::MsgPack::boolean>();
     EXPECT_EQ(val1, val2);
 }
 
@@ -271,9 +271,9 @@ TEST(MSGPACK, simple_buffer_fixext1)
     std::string err;
     msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(packed.dump(), err ) };
 
-    EXPECT_EQ(data.size(), std::get<1>(parsed.extension_items()).size());
-    EXPECT_EQ(type, std::get<0>(parsed.extension_items()));
-    EXPECT_EQ(data[0],  std::get<1>(parsed.extension_items())[0]);
+    EXPECT_EQ(data.size(), std::get<1>(parsed.as<msgpack11::MsgPack::extension>()).size());
+    EXPECT_EQ(type, std::get<0>(parsed.as<msgpack11::MsgPack::extension>()));
+    EXPECT_EQ(data[0],  std::get<1>(parsed.as<msgpack11::MsgPack::extension>())[0]);
 }
 
 TEST(MSGPACK, simple_buffer_fixext2)
@@ -284,8 +284,8 @@ TEST(MSGPACK, simple_buffer_fixext2)
 
     std::string err;
     msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(packed.dump(), err ) };
-    const uint8_t parsed_type = std::get<0>( parsed.extension_items() );
-    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.extension_items() );
+    const uint8_t parsed_type = std::get<0>( parsed.as<msgpack11::MsgPack::extension>() );
+    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.as<msgpack11::MsgPack::extension>() );
 
     EXPECT_EQ(data.size(), parsed_data.size());
     EXPECT_EQ(type, parsed_type);
@@ -300,8 +300,8 @@ TEST(MSGPACK, simple_buffer_fixext4)
 
     std::string err;
     msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(packed.dump(), err ) };
-    const uint8_t parsed_type = std::get<0>( parsed.extension_items() );
-    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.extension_items() );
+    const uint8_t parsed_type = std::get<0>( parsed.as<msgpack11::MsgPack::extension>() );
+    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.as<msgpack11::MsgPack::extension>() );
 
     EXPECT_EQ(data.size(), parsed_data.size());
     EXPECT_EQ(type, parsed_type);
@@ -316,8 +316,8 @@ TEST(MSGPACK, simple_buffer_fixext8)
 
     std::string err;
     msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(packed.dump(), err ) };
-    const uint8_t parsed_type = std::get<0>( parsed.extension_items() );
-    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.extension_items() );
+    const uint8_t parsed_type = std::get<0>( parsed.as<msgpack11::MsgPack::extension>() );
+    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.as<msgpack11::MsgPack::extension>() );
 
     EXPECT_EQ(data.size(), parsed_data.size());
     EXPECT_EQ(type, parsed_type);
@@ -332,8 +332,8 @@ TEST(MSGPACK, simple_buffer_fixext16)
 
     std::string err;
     msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(packed.dump(), err ) };
-    const uint8_t parsed_type = std::get<0>( parsed.extension_items() );
-    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.extension_items() );
+    const uint8_t parsed_type = std::get<0>( parsed.as<msgpack11::MsgPack::extension>() );
+    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.as<msgpack11::MsgPack::extension>() );
 
     EXPECT_EQ(data.size(), parsed_data.size());
     EXPECT_EQ(type, parsed_type);
@@ -348,8 +348,8 @@ TEST(MSGPACK, simple_buffer_fixext_1byte_0)
 
     std::string err;
     msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(packed.dump(), err ) };
-    const uint8_t parsed_type = std::get<0>( parsed.extension_items() );
-    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.extension_items() );
+    const uint8_t parsed_type = std::get<0>( parsed.as<msgpack11::MsgPack::extension>() );
+    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.as<msgpack11::MsgPack::extension>() );
 
     EXPECT_EQ(data.size(), parsed_data.size());
     EXPECT_EQ(type, parsed_type);
@@ -365,8 +365,8 @@ TEST(MSGPACK, simple_buffer_fixext_1byte_255)
 
     std::string err;
     msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(packed.dump(), err ) };
-    const uint8_t parsed_type = std::get<0>( parsed.extension_items() );
-    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.extension_items() );
+    const uint8_t parsed_type = std::get<0>( parsed.as<msgpack11::MsgPack::extension>() );
+    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.as<msgpack11::MsgPack::extension>() );
 
     EXPECT_EQ(data.size(), parsed_data.size());
     EXPECT_EQ(type, parsed_type);
@@ -382,8 +382,8 @@ TEST(MSGPACK, simple_buffer_fixext_2byte_256)
 
     std::string err;
     msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(packed.dump(), err ) };
-    const uint8_t parsed_type = std::get<0>( parsed.extension_items() );
-    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.extension_items() );
+    const uint8_t parsed_type = std::get<0>( parsed.as<msgpack11::MsgPack::extension>() );
+    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.as<msgpack11::MsgPack::extension>() );
 
     EXPECT_EQ(data.size(), parsed_data.size());
     EXPECT_EQ(type, parsed_type);
@@ -399,8 +399,8 @@ TEST(MSGPACK, simple_buffer_fixext_2byte_65535)
 
     std::string err;
     msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(packed.dump(), err ) };
-    const uint8_t parsed_type = std::get<0>( parsed.extension_items() );
-    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.extension_items() );
+    const uint8_t parsed_type = std::get<0>( parsed.as<msgpack11::MsgPack::extension>() );
+    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.as<msgpack11::MsgPack::extension>() );
 
     EXPECT_EQ(data.size(), parsed_data.size());
     EXPECT_EQ(type, parsed_type);
@@ -416,8 +416,8 @@ TEST(MSGPACK, simple_buffer_fixext_4byte_65536)
 
     std::string err;
     msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(packed.dump(), err ) };
-    const uint8_t parsed_type = std::get<0>( parsed.extension_items() );
-    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.extension_items() );
+    const uint8_t parsed_type = std::get<0>( parsed.as<msgpack11::MsgPack::extension>() );
+    const msgpack11::MsgPack::binary& parsed_data = std::get<1>( parsed.as<msgpack11::MsgPack::extension>() );
 
     EXPECT_EQ(data.size(), parsed_data.size());
     EXPECT_EQ(type, parsed_type);
@@ -436,7 +436,7 @@ TEST(MSGPACK_STL, simple_buffer_string)
         msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(packed.dump(), err ) };
 
         EXPECT_EQ(parsed.type(), msgpack11::MsgPack::Type::STRING);
-        string val2 = parsed.string_value();
+        string val2 = parsed.as<msgpack11::MsgPack::string>();
         EXPECT_EQ(val1.size(), val2.size());
         EXPECT_EQ(val1, val2);
     }
@@ -454,7 +454,7 @@ TEST(MSGPACK_STL, simple_buffer_cstring)
         msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(packed.dump(), err ) };
 
         EXPECT_EQ(parsed.type(), msgpack11::MsgPack::Type::STRING);
-        string val2 = parsed.string_value();
+        string val2 = parsed.as<msgpack11::MsgPack::string>();
         EXPECT_EQ(val1.size(), val2.size());
         EXPECT_EQ(val1, val2);
     }
@@ -477,7 +477,7 @@ TEST(MSGPACK_STL, simple_buffer_non_const_cstring)
         msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(packed.dump(), err ) };
 
         EXPECT_EQ(parsed.type(), msgpack11::MsgPack::Type::STRING);
-        string val2 = parsed.string_value();
+        string val2 = parsed.as<msgpack11::MsgPack::string>();
         EXPECT_EQ(val1.size(), val2.size());
         EXPECT_EQ(val1, val2);
     }
@@ -730,7 +730,7 @@ TEST(MSGPACK_PREDICATES, predicates_null)
 {
     msgpack11::MsgPack null_value;
     EXPECT_TRUE(null_value.is_null());
-    EXPECT_FALSE(null_value.is_bool());
+    EXPECT_FALSE(null_value.is_boolean());
     EXPECT_FALSE(null_value.is_number());
     EXPECT_FALSE(null_value.is_float32());
     EXPECT_FALSE(null_value.is_float64());
@@ -754,7 +754,7 @@ TEST(MSGPACK_PREDICATES, predicates_float)
 {
     msgpack11::MsgPack float_value(0.0f);
     EXPECT_FALSE(float_value.is_null());
-    EXPECT_FALSE(float_value.is_bool());
+    EXPECT_FALSE(float_value.is_boolean());
     EXPECT_TRUE(float_value.is_number());
     EXPECT_TRUE(float_value.is_float32());
     EXPECT_FALSE(float_value.is_float64());
@@ -778,7 +778,7 @@ TEST(MSGPACK_PREDICATES, predicates_double)
 {
     msgpack11::MsgPack double_value(0.0);
     EXPECT_FALSE(double_value.is_null());
-    EXPECT_FALSE(double_value.is_bool());
+    EXPECT_FALSE(double_value.is_boolean());
     EXPECT_TRUE(double_value.is_number());
     EXPECT_FALSE(double_value.is_float32());
     EXPECT_TRUE(double_value.is_float64());
@@ -802,7 +802,7 @@ TEST(MSGPACK_PREDICATES, predicates_int8)
 {
     msgpack11::MsgPack double_value(static_cast<int8_t>(0x00));
     EXPECT_FALSE(double_value.is_null());
-    EXPECT_FALSE(double_value.is_bool());
+    EXPECT_FALSE(double_value.is_boolean());
     EXPECT_TRUE(double_value.is_number());
     EXPECT_FALSE(double_value.is_float32());
     EXPECT_FALSE(double_value.is_float64());
@@ -826,7 +826,7 @@ TEST(MSGPACK_PREDICATES, predicates_int16)
 {
     msgpack11::MsgPack double_value(static_cast<int16_t>(0x00));
     EXPECT_FALSE(double_value.is_null());
-    EXPECT_FALSE(double_value.is_bool());
+    EXPECT_FALSE(double_value.is_boolean());
     EXPECT_TRUE(double_value.is_number());
     EXPECT_FALSE(double_value.is_float32());
     EXPECT_FALSE(double_value.is_float64());
@@ -850,7 +850,7 @@ TEST(MSGPACK_PREDICATES, predicates_int32)
 {
     msgpack11::MsgPack double_value(static_cast<int32_t>(0x00));
     EXPECT_FALSE(double_value.is_null());
-    EXPECT_FALSE(double_value.is_bool());
+    EXPECT_FALSE(double_value.is_boolean());
     EXPECT_TRUE(double_value.is_number());
     EXPECT_FALSE(double_value.is_float32());
     EXPECT_FALSE(double_value.is_float64());
@@ -874,7 +874,7 @@ TEST(MSGPACK_PREDICATES, predicates_int64)
 {
     msgpack11::MsgPack double_value(static_cast<int64_t>(0x00));
     EXPECT_FALSE(double_value.is_null());
-    EXPECT_FALSE(double_value.is_bool());
+    EXPECT_FALSE(double_value.is_boolean());
     EXPECT_TRUE(double_value.is_number());
     EXPECT_FALSE(double_value.is_float32());
     EXPECT_FALSE(double_value.is_float64());
@@ -898,7 +898,7 @@ TEST(MSGPACK_PREDICATES, predicates_uint8)
 {
     msgpack11::MsgPack double_value(static_cast<uint8_t>(0x00));
     EXPECT_FALSE(double_value.is_null());
-    EXPECT_FALSE(double_value.is_bool());
+    EXPECT_FALSE(double_value.is_boolean());
     EXPECT_TRUE(double_value.is_number());
     EXPECT_FALSE(double_value.is_float32());
     EXPECT_FALSE(double_value.is_float64());
@@ -922,7 +922,7 @@ TEST(MSGPACK_PREDICATES, predicates_uint16)
 {
     msgpack11::MsgPack double_value(static_cast<uint16_t>(0x00));
     EXPECT_FALSE(double_value.is_null());
-    EXPECT_FALSE(double_value.is_bool());
+    EXPECT_FALSE(double_value.is_boolean());
     EXPECT_TRUE(double_value.is_number());
     EXPECT_FALSE(double_value.is_float32());
     EXPECT_FALSE(double_value.is_float64());
@@ -946,7 +946,7 @@ TEST(MSGPACK_PREDICATES, predicates_uint32)
 {
     msgpack11::MsgPack double_value(static_cast<uint32_t>(0x00));
     EXPECT_FALSE(double_value.is_null());
-    EXPECT_FALSE(double_value.is_bool());
+    EXPECT_FALSE(double_value.is_boolean());
     EXPECT_TRUE(double_value.is_number());
     EXPECT_FALSE(double_value.is_float32());
     EXPECT_FALSE(double_value.is_float64());
@@ -970,7 +970,7 @@ TEST(MSGPACK_PREDICATES, predicates_uint64)
 {
     msgpack11::MsgPack double_value(static_cast<uint64_t>(0x00));
     EXPECT_FALSE(double_value.is_null());
-    EXPECT_FALSE(double_value.is_bool());
+    EXPECT_FALSE(double_value.is_boolean());
     EXPECT_TRUE(double_value.is_number());
     EXPECT_FALSE(double_value.is_float32());
     EXPECT_FALSE(double_value.is_float64());
@@ -994,7 +994,7 @@ TEST(MSGPACK_PREDICATES, predicates_bool)
 {
     msgpack11::MsgPack bool_value(true);
     EXPECT_FALSE(bool_value.is_null());
-    EXPECT_TRUE(bool_value.is_bool());
+    EXPECT_TRUE(bool_value.is_boolean());
     EXPECT_FALSE(bool_value.is_number());
     EXPECT_FALSE(bool_value.is_float32());
     EXPECT_FALSE(bool_value.is_float64());
@@ -1018,7 +1018,7 @@ TEST(MSGPACK_PREDICATES, predicates_string)
 {
     msgpack11::MsgPack string_value(std::string{});
     EXPECT_FALSE(string_value.is_null());
-    EXPECT_FALSE(string_value.is_bool());
+    EXPECT_FALSE(string_value.is_boolean());
     EXPECT_FALSE(string_value.is_number());
     EXPECT_FALSE(string_value.is_float32());
     EXPECT_FALSE(string_value.is_float64());
@@ -1042,7 +1042,7 @@ TEST(MSGPACK_PREDICATES, predicates_array)
 {
     msgpack11::MsgPack array_value(msgpack11::MsgPack::array{});
     EXPECT_FALSE(array_value.is_null());
-    EXPECT_FALSE(array_value.is_bool());
+    EXPECT_FALSE(array_value.is_boolean());
     EXPECT_FALSE(array_value.is_number());
     EXPECT_FALSE(array_value.is_float32());
     EXPECT_FALSE(array_value.is_float64());
@@ -1066,7 +1066,7 @@ TEST(MSGPACK_PREDICATES, predicates_binary)
 {
     msgpack11::MsgPack binary_value(msgpack11::MsgPack::binary{});
     EXPECT_FALSE(binary_value.is_null());
-    EXPECT_FALSE(binary_value.is_bool());
+    EXPECT_FALSE(binary_value.is_boolean());
     EXPECT_FALSE(binary_value.is_number());
     EXPECT_FALSE(binary_value.is_float32());
     EXPECT_FALSE(binary_value.is_float64());
@@ -1090,7 +1090,7 @@ TEST(MSGPACK_PREDICATES, predicates_object)
 {
     msgpack11::MsgPack object_value(msgpack11::MsgPack::object{});
     EXPECT_FALSE(object_value.is_null());
-    EXPECT_FALSE(object_value.is_bool());
+    EXPECT_FALSE(object_value.is_boolean());
     EXPECT_FALSE(object_value.is_number());
     EXPECT_FALSE(object_value.is_float32());
     EXPECT_FALSE(object_value.is_float64());
@@ -1114,7 +1114,7 @@ TEST(MSGPACK_PREDICATES, predicates_extension)
 {
     msgpack11::MsgPack extension_value(msgpack11::MsgPack::extension{});
     EXPECT_FALSE(extension_value.is_null());
-    EXPECT_FALSE(extension_value.is_bool());
+    EXPECT_FALSE(extension_value.is_boolean());
     EXPECT_FALSE(extension_value.is_number());
     EXPECT_FALSE(extension_value.is_float32());
     EXPECT_FALSE(extension_value.is_float64());
@@ -0,0 +1,107 @@
+#include <msgpack11.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sample.hpp"
+
+namespace {
+
+bool points_into(const void *p, const std::string &buffer)
+{
+    auto const *c = static_cast<const char *>(p);
+    return c >= buffer.data() && c < buffer.data() + buffer.size();
+}
+
+}
+
+TEST(MSGPACK_BORROW, matches_parse)
+{
+    std::string const encoded = sample().dump();
+    std::string err;
+    msgpack11::MsgPack const borrowed = msgpack11::MsgPack::parse_borrowed(encoded, err);
+    ASSERT_TRUE(err.empty());
+    EXPECT_EQ(borrowed, sample());
+    EXPECT_EQ(msgpack11::MsgPack::parse(borrowed.dump(), err), sample());
+    EXPECT_EQ(borrowed.encoded_size(), encoded.size());
+    EXPECT_EQ(borrowed["name"].as<std::string>(), "router");
+    EXPECT_EQ(borrowed["user"]["tags"][2].as<msgpack11::MsgPack::binary>(), (msgpack11::MsgPack::binary { 1, 2 }));
+}
+
+TEST(MSGPACK_BORROW, views_point_into_the_input)
+{
+    std::string const encoded = sample().dump();
+    std::string err;
+    msgpack11::MsgPack const borrowed = msgpack11::MsgPack::parse_borrowed(encoded, err);
+
+    std::string_view const name = borrowed["name"].as<std::string_view>();
+    EXPECT_EQ(name, "router");
+    EXPECT_TRUE(points_into(name.data(), encoded));
+
+    std::span<const uint8_t> const data = borrowed["data"].as<std::span<const uint8_t>>();
+    EXPECT_EQ(data.size(), 300u);
+    EXPECT_TRUE(points_into(data.data(), encoded));
+
+    // Keys are borrowed too, and still find their entries.
+    EXPECT_TRUE(points_into(borrowed.as<msgpack11::MsgPack::object>().find("user")->first.as<std::string_view>().data(), encoded));
+
+    // A copying parse reads the same through views.
+    msgpack11::MsgPack const copied = msgpack11::MsgPack::parse(encoded, err);
+    EXPECT_EQ(copied["name"].as<std::string_view>(), "router");
+    EXPECT_FALSE(points_into(copied["name"].as<std::string_view>().data(), encoded));
+    EXPECT_THROW(copied["name"].as<std::span<const uint8_t>>(), std::runtime_error);
+    EXPECT_THROW(copied["data"].as<std::string_view>(), std::runtime_error);
+}
+
+TEST(MSGPACK_BORROW, copied_on_mutation)
+{
+    std::string encoded = sample().dump();
+    std::string err;
+    msgpack11::MsgPack borrowed = msgpack11::MsgPack::parse_borrowed(encoded, err);
+
+    std::string &name = borrowed["name"].as<std::string>();
+    EXPECT_FALSE(points_into(name.data(), encoded));
+    name += "-large";
+    EXPECT_EQ(borrowed["name"].as<std::string_view>(), "router-large");
+
+    borrowed["data"].as<msgpack11::MsgPack::binary>()[0] = 0;
+    msgpack11::MsgPack const reparsed = msgpack11::MsgPack::parse(borrowed.dump(), err);
+    EXPECT_TRUE(err.empty());
+    EXPECT_EQ(reparsed["name"].as<std::string>(), "router-large");
+    EXPECT_EQ(reparsed["data"].as<msgpack11::MsgPack::binary>()[0], 0);
+    EXPECT_EQ(reparsed["data"].as<msgpack11::MsgPack::binary>()[1], 0xab);
+}
+
+TEST(MSGPACK_BORROW, owner)
+{
+    auto buffer = std::make_shared<std::string>(sample().dump());
+    std::weak_ptr<std::string> const watch = buffer;
+    std::string err;
+    msgpack11::MsgPack name;
+    {
+        msgpack11::MsgPack const borrowed = msgpack11::MsgPack::parse_borrowed(*buffer, err, {}, buffer);
+        buffer.reset();
+
+        // The values still pointing into the buffer keep it alive.
+        EXPECT_FALSE(watch.expired());
+        EXPECT_EQ(borrowed, sample());
+        name = borrowed["name"];
+    }
+
+    // Until the last of them goes.
+    EXPECT_FALSE(watch.expired());
+    EXPECT_EQ(name.as<std::string_view>(), "router");
+    name = nullptr;
+    EXPECT_TRUE(watch.expired());
+}
+
+TEST(MSGPACK_BORROW, errors)
+{
+    std::string err;
+    msgpack11::MsgPack const truncated = msgpack11::MsgPack::parse_borrowed(std::string_view("\x92\xa3" "ab", 4), err);
+    EXPECT_EQ(err, "end of buffer.");
+    EXPECT_TRUE(truncated.is_null());
+}
@@ -0,0 +1,126 @@
+#include <msgpack11.hpp>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+msgpack11::MsgPack document(bool reversed, size_t buckets)
+{
+    msgpack11::MsgPack::object fields;
+    fields.rehash(buckets);
+    for (int i = 0; i < 50; ++i) {
+        int const n = reversed ? 49 - i : i;
+        fields["key" + std::to_string(n)] = msgpack11::MsgPack::object {
+            { "n", n },
+            { "tags", msgpack11::MsgPack::array { "x", n % 3 } }
+        };
+    }
+    return fields;
+}
+
+}
+
+TEST(MSGPACK_CANONICAL, independent_of_insertion)
+{
+    msgpack11::MsgPack const a = document(false, 0);
+    msgpack11::MsgPack const b = document(true, 1024);
+    ASSERT_EQ(a, b);
+
+    std::string const bytes = a.dump(msgpack11::Canonical());
+    EXPECT_EQ(b.dump(msgpack11::Canonical()), bytes);
+    EXPECT_EQ(a.fingerprint(), b.fingerprint());
+
+    std::string err;
+    EXPECT_EQ(msgpack11::MsgPack::parse(bytes, err), a);
+    EXPECT_EQ(msgpack11::MsgPack::parse(bytes, err).dump(msgpack11::Canonical()), bytes);
+    EXPECT_TRUE(err.empty());
+}
+
+TEST(MSGPACK_CANONICAL, key_order)
+{
+    // Entries go in the byte order of their encoded keys.
+    msgpack11::MsgPack const value = msgpack11::MsgPack::object {
+        { "b", 1 }, { "aa", 3 }, { "a", 2 }, { 300, nullptr }, { -1, false }
+    };
+    EXPECT_EQ(value.dump(msgpack11::Canonical()),
+              std::string("\x85" "\xa1" "a" "\x02" "\xa1" "b" "\x01" "\xa2" "aa" "\x03" "\xcd\x01\x2c" "\xc0" "\xff" "\xc2", 17));
+}
+
+TEST(MSGPACK_CANONICAL, smallest_encodings)
+{
+    // {"a": [1]} with a map16 header, an array16 header and a uint32, which
+    // a lazy parse copies back out as they are.
+    std::string const loose("\xde\x00\x01" "\xa1" "a" "\xdc\x00\x01" "\xce\x00\x00\x00\x01", 13);
+    std::string err;
+    msgpack11::MsgPack const lazy = msgpack11::MsgPack::parse_lazy(loose, err);
+    ASSERT_TRUE(err.empty());
+    EXPECT_EQ(lazy.dump(), loose);
+    EXPECT_EQ(lazy.dump(msgpack11::Canonical()), std::string("\x81\xa1" "a" "\x91\x01", 5));
+
+    msgpack11::MsgPack const borrowed = msgpack11::MsgPack::parse_borrowed(loose, err);
+    EXPECT_EQ(borrowed.dump(msgpack11::Canonical()), lazy.dump(msgpack11::Canonical()));
+    EXPECT_EQ(borrowed.fingerprint(), lazy.fingerprint());
+
+    // Integers of any C++ type that hold the same value encode the same.
+    EXPECT_EQ(msgpack11::MsgPack(static_cast<uint32_t>(5)).dump(msgpack11::Canonical()),
+              msgpack11::MsgPack(static_cast<int64_t>(5)).dump(msgpack11::Canonical()));
+}
+
+TEST(MSGPACK_CANONICAL, changes_are_seen)
+{
+    msgpack11::MsgPack value = document(false, 0);
+    std::string const before = value.dump(msgpack11::Canonical());
+    uint64_t const fingerprint = value.fingerprint();
+    EXPECT_EQ(value.dump(msgpack11::Canonical()), before);
+
+    value["key7"]["tags"][0] = "y";
+    std::string const after = value.dump(msgpack11::Canonical());
+    EXPECT_NE(after, before);
+    EXPECT_NE(value.fingerprint(), fingerprint);
+
+    std::string err;
+    EXPECT_EQ(msgpack11::MsgPack::parse(after, err)["key7"]["tags"][0].as<std::string>(), "y");
+
+    // Changing it on through the same reference is seen as well.
+    value["key7"]["tags"][0] = "x";
+    EXPECT_EQ(value.dump(msgpack11::Canonical()), before);
+    EXPECT_EQ(value.fingerprint(), fingerprint);
+}
+
+TEST(MSGPACK_CANONICAL, members_changed_elsewhere)
+{
+    // A member shared with another value and changed through it.
+    msgpack11::MsgPack tags = msgpack11::MsgPack::array { "x", 1 };
+    msgpack11::MsgPack const value = msgpack11::MsgPack::object {
+        { "tags", tags }, { "items", msgpack11::MsgPack::array { msgpack11::MsgPack::object { { "k", 1 } } } }
+    };
+    std::string const before = value.dump(msgpack11::Canonical());
+
+    tags[0] = "y";
+    std::string const after = value.dump(msgpack11::Canonical());
+    EXPECT_NE(after, before);
+    std::string err;
+    EXPECT_EQ(msgpack11::MsgPack::parse(after, err), value);
+}
+
+TEST(MSGPACK_CANONICAL, document)
+{
+    msgpack11::MsgPack const value = document(true, 64);
+    std::string err;
+    msgpack11::Document const parsed(value.dump(), err);
+    ASSERT_TRUE(err.empty());
+    EXPECT_EQ(parsed.root().dump(msgpack11::Canonical()), value.dump(msgpack11::Canonical()));
+    EXPECT_EQ(parsed.root().fingerprint(), value.fingerprint());
+    EXPECT_EQ(parsed.root()["key7"].fingerprint(), value["key7"].fingerprint());
+}
+
+TEST(MSGPACK_CANONICAL, equal_encodings)
+{
+    // Fingerprints follow the encoding: integers match whatever their C++
+    // type, but floats keep their width and are never taken for integers.
+    EXPECT_EQ(msgpack11::MsgPack(static_cast<uint8_t>(1)).fingerprint(), msgpack11::MsgPack(static_cast<int64_t>(1)).fingerprint());
+    EXPECT_NE(msgpack11::MsgPack(1).fingerprint(), msgpack11::MsgPack(1.0).fingerprint());
+    EXPECT_NE(msgpack11::MsgPack(1.0).fingerprint(), msgpack11::MsgPack(1.0f).fingerprint());
+}
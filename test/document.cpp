@@ -0,0 +1,65 @@
+#include <msgpack11.hpp>
+
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+#include "sample.hpp"
+
+TEST(MSGPACK_DOCUMENT, matches_parse)
+{
+    std::string const encoded = sample().dump();
+
+    std::string err;
+    msgpack11::Document doc(encoded, err);
+    EXPECT_TRUE(err.empty());
+    EXPECT_EQ(doc.root(), sample());
+    EXPECT_EQ(doc.root().encoded_size(), encoded.size());
+    EXPECT_EQ(msgpack11::MsgPack::parse(doc.root().dump(), err), sample());
+}
+
+TEST(MSGPACK_DOCUMENT, parse_error)
+{
+    std::string const encoded = sample().dump();
+
+    std::string err;
+    msgpack11::Document doc(std::string_view(encoded).substr(0, encoded.size() - 3), err);
+    EXPECT_FALSE(err.empty());
+    EXPECT_TRUE(doc.root().is_null());
+}
+
+TEST(MSGPACK_DOCUMENT, duplicate_keys)
+{
+    // fixmap of two entries, both keyed "k" with 32-byte string values.
+    std::string encoded{"\x82\xa1k\xd9\x20", 5};
+    encoded += std::string(32, 'a');
+    encoded += std::string{"\xa1k\xd9\x20"};
+    encoded += std::string(32, 'b');
+
+    std::string err;
+    msgpack11::Document doc(encoded, err);
+    EXPECT_TRUE(err.empty());
+    ASSERT_EQ(doc.root().as<msgpack11::MsgPack::object>().size(), 1u);
+    EXPECT_EQ(doc.root()["k"], msgpack11::MsgPack(std::string(32, 'a')));
+}
+
+TEST(MSGPACK_DOCUMENT, move)
+{
+    std::string const encoded = sample().dump();
+
+    std::string err;
+    msgpack11::Document first(encoded, err);
+    msgpack11::Document doc(std::move(first));
+    EXPECT_TRUE(first.root().is_null());
+    EXPECT_EQ(doc.root(), sample());
+
+    first = std::move(doc);
+    EXPECT_TRUE(doc.root().is_null());
+    EXPECT_EQ(first.root(), sample());
+
+    // Copies of containers allocate from the default resource again.
+    msgpack11::MsgPack::array items = first.root()["items"].as<msgpack11::MsgPack::array>();
+    EXPECT_EQ(items.get_allocator().resource(), std::pmr::get_default_resource());
+    EXPECT_EQ(items.size(), 4u);
+}
@@ -0,0 +1,118 @@
+#include <msgpack11.hpp>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(MSGPACK_DUMP, dump_to_string_appends)
+{
+    msgpack11::MsgPack packed{msgpack11::MsgPack::array{ 1, "abc", msgpack11::MsgPack::binary{ 0, 1, 2 } }};
+
+    std::string out{"\x01"};
+    packed.dump_to(out);
+    EXPECT_EQ(out.size(), 1u + packed.dump().size());
+    EXPECT_EQ(out.substr(1), packed.dump());
+}
+
+TEST(MSGPACK_DUMP, dump_to_binary)
+{
+    msgpack11::MsgPack packed{msgpack11::MsgPack::object{
+        { "key1", std::string(300, 'x') },
+        { "key2", msgpack11::MsgPack::extension{ 5, msgpack11::MsgPack::binary(70000, 7) } }
+    }};
+
+    std::string dumped{packed.dump()};
+    msgpack11::MsgPack::binary out;
+    packed.dump_to(out);
+    ASSERT_EQ(out.size(), dumped.size());
+    EXPECT_TRUE(std::equal(out.begin(), out.end(), reinterpret_cast<const uint8_t*>(dumped.data())));
+}
+
+TEST(MSGPACK_DUMP, dump_to_reuses_capacity)
+{
+    msgpack11::MsgPack packed{msgpack11::MsgPack::array(100, std::string(20, 'a'))};
+
+    std::string out;
+    packed.dump_to(out);
+    const size_t capacity = out.capacity();
+    const char* data = out.data();
+
+    out.clear();
+    packed.dump_to(out);
+    EXPECT_EQ(out.capacity(), capacity);
+    EXPECT_EQ(out.data(), data);
+    EXPECT_EQ(out, packed.dump());
+}
+
+TEST(MSGPACK_DUMP, encoded_size_matches_dump)
+{
+    using msgpack11::MsgPack;
+    MsgPack::array values{
+        nullptr, true, 1.5f, 2.5,
+        MsgPack::uint8(127), MsgPack::uint8(128), MsgPack::uint16(300), MsgPack::uint32(70000), MsgPack::uint64(1ULL << 40),
+        MsgPack::int8(-32), MsgPack::int8(-33), MsgPack::int16(-200), MsgPack::int32(-40000), MsgPack::int64(-(1LL << 40)),
+        MsgPack::int64(5), std::string(31, 'a'), std::string(32, 'a'), std::string(300, 'a'), std::string(70000, 'a'),
+        MsgPack::binary(10), MsgPack::binary(300), MsgPack::binary(70000),
+        MsgPack::extension{ 1, MsgPack::binary(4) }, MsgPack::extension{ 1, MsgPack::binary(3) },
+        MsgPack::extension{ 1, MsgPack::binary(300) }, MsgPack::extension{ 1, MsgPack::binary(70000) },
+        MsgPack::array(16, 1), MsgPack::object{ { "k", MsgPack::array{} } }
+    };
+    for (const MsgPack& value : values)
+    {
+        EXPECT_EQ(value.encoded_size(), value.dump().size());
+    }
+    MsgPack packed{values};
+    EXPECT_EQ(packed.encoded_size(), packed.dump().size());
+}
+
+TEST(MSGPACK_DUMP, encoded_size_follows_mutation)
+{
+    using msgpack11::MsgPack;
+    MsgPack inner{MsgPack::array{ 1, 2 }};
+    MsgPack outer{MsgPack::array{ inner, "x" }};
+    const size_t before = outer.encoded_size();
+    EXPECT_EQ(before, outer.dump().size());
+
+    // inner shares its array with the first element of outer.
+    inner.as<MsgPack::array>().push_back(std::string(40, 'y'));
+    EXPECT_EQ(outer.encoded_size(), outer.dump().size());
+    EXPECT_GT(outer.encoded_size(), before);
+
+    // A reference taken earlier keeps the size from being cached again.
+    MsgPack::string& str = outer[1].as<MsgPack::string>();
+    outer.encoded_size();
+    str.append(100, 'z');
+    EXPECT_EQ(outer.encoded_size(), outer.dump().size());
+}
+
+TEST(MSGPACK_DUMP, encoded_size_follows_shared_members)
+{
+    using msgpack11::MsgPack;
+    MsgPack leaf{"abc"};
+    MsgPack left{MsgPack::array{ MsgPack::array{ leaf } }};
+    MsgPack right{MsgPack::object{ { "k", leaf } }};
+    const size_t left_before = left.encoded_size();
+    const size_t right_before = right.encoded_size();
+
+    // leaf is counted by both containers, and by an array inside left.
+    leaf.as<MsgPack::string>().append(40, 'y');
+    EXPECT_EQ(left.encoded_size(), left_before + 40 + 1);
+    EXPECT_EQ(right.encoded_size(), right_before + 40 + 1);
+    EXPECT_EQ(left.encoded_size(), left.dump().size());
+    EXPECT_EQ(right.encoded_size(), right.dump().size());
+}
+
+TEST(MSGPACK_DUMP, encoded_size_outlives_container)
+{
+    using msgpack11::MsgPack;
+    MsgPack leaf{"abc"};
+    {
+        MsgPack outer{MsgPack::array{ leaf }};
+        outer.encoded_size();
+    }
+    MsgPack again{MsgPack::array{ leaf }};
+    const size_t before = again.encoded_size();
+    leaf.as<MsgPack::string>().append(40, 'y');
+    EXPECT_EQ(again.encoded_size(), before + 40 + 1);
+}
@@ -0,0 +1,106 @@
+#include <msgpack11.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// A file holding contents, removed again when the test is done.
+class TempFile
+{
+public:
+    TempFile(const std::string &name, const std::string &contents) : path(testing::TempDir() + name)
+    {
+        std::ofstream(path, std::ios::binary) << contents;
+    }
+    ~TempFile() { std::remove(path.c_str()); }
+
+    std::string const path;
+};
+
+std::vector<msgpack11::MsgPack> samples()
+{
+    return {
+        msgpack11::MsgPack::object { { "name", "first" }, { "blob", msgpack11::MsgPack::binary(5000, 7) } },
+        msgpack11::MsgPack::array { 1, 2.5, "three" },
+        msgpack11::MsgPack(std::string(100, 'x'))
+    };
+}
+
+std::string concatenated()
+{
+    std::string encoded;
+    for (const auto &sample : samples())
+        encoded += sample.dump();
+    return encoded;
+}
+
+}
+
+TEST(MSGPACK_FILE, mapped_file)
+{
+    std::string const contents = concatenated();
+    TempFile const file("msgpack11_mapped_file", contents);
+
+    std::string err;
+    msgpack11::MappedFile mapped(file.path, err);
+    EXPECT_TRUE(err.empty());
+    EXPECT_EQ(mapped.view(), contents);
+
+    msgpack11::MappedFile moved(std::move(mapped));
+    EXPECT_EQ(mapped.size(), 0u);
+    EXPECT_EQ(moved.size(), contents.size());
+
+    TempFile const empty("msgpack11_mapped_empty", "");
+    msgpack11::MappedFile nothing(empty.path, err);
+    EXPECT_TRUE(err.empty());
+    EXPECT_TRUE(nothing.bytes().empty());
+
+    msgpack11::MappedFile missing(testing::TempDir() + "msgpack11_no_such_file", err);
+    EXPECT_FALSE(err.empty());
+    EXPECT_TRUE(missing.bytes().empty());
+}
+
+TEST(MSGPACK_FILE, parse_file)
+{
+    TempFile const file("msgpack11_parse_file", samples()[0].dump());
+
+    std::string err;
+    EXPECT_EQ(msgpack11::MsgPack::parse_file(file.path, err), samples()[0]);
+    EXPECT_TRUE(err.empty());
+
+    // Borrowed values keep the mapping alive after parse_file() returns.
+    msgpack11::MsgPack const borrowed = msgpack11::MsgPack::parse_file(file.path, err, {}, true);
+    EXPECT_TRUE(err.empty());
+    EXPECT_EQ(borrowed["blob"].as<std::span<const uint8_t>>().size(), 5000u);
+    EXPECT_EQ(borrowed, samples()[0]);
+
+    msgpack11::MsgPack::parse_file(testing::TempDir() + "msgpack11_no_such_file", err);
+    EXPECT_FALSE(err.empty());
+}
+
+TEST(MSGPACK_FILE, for_each_message)
+{
+    TempFile const file("msgpack11_for_each_message", concatenated());
+
+    for (bool borrow : { false, true }) {
+        std::vector<msgpack11::MsgPack> seen;
+        std::string err;
+        size_t const count = msgpack11::MsgPack::for_each_message(file.path, [&](const msgpack11::MsgPack &message) {
+            seen.push_back(message);
+        }, err, {}, borrow);
+        EXPECT_TRUE(err.empty());
+        EXPECT_EQ(count, 3u);
+        EXPECT_EQ(seen, samples());
+    }
+
+    TempFile const truncated("msgpack11_for_each_truncated", concatenated() + "\x92\x01");
+    std::string err;
+    size_t const count = msgpack11::MsgPack::for_each_message(truncated.path, [](const msgpack11::MsgPack &) {}, err);
+    EXPECT_EQ(count, 3u);
+    EXPECT_EQ(err, "end of buffer.");
+}
@@ -0,0 +1,83 @@
+#include <msgpack11.hpp>
+
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+#include "sample.hpp"
+
+namespace {
+
+std::string joined(const msgpack11::GatherDump& dump)
+{
+    std::string out;
+    for (const iovec& piece : dump.iov())
+        out.append(static_cast<const char*>(piece.iov_base), piece.iov_len);
+    return out;
+}
+
+bool referenced(const msgpack11::GatherDump& dump, const void* data)
+{
+    for (const iovec& piece : dump.iov())
+        if (piece.iov_base == data)
+            return true;
+    return false;
+}
+
+}
+
+TEST(MSGPACK_GATHER, matches_dump)
+{
+    msgpack11::MsgPack const value = sample(8000);
+    for (size_t min_reference : { 0, 1, 16, 4096, 1 << 20 }) {
+        msgpack11::GatherDump const dump(value, min_reference);
+        EXPECT_EQ(joined(dump), value.dump()) << min_reference;
+        EXPECT_EQ(dump.size(), value.encoded_size()) << min_reference;
+    }
+}
+
+TEST(MSGPACK_GATHER, large_payloads_in_place)
+{
+    msgpack11::MsgPack const value = sample(8000);
+    msgpack11::GatherDump const dump(value);
+
+    EXPECT_TRUE(referenced(dump, value["data"].as<std::span<const uint8_t>>().data()));
+    EXPECT_TRUE(referenced(dump, value["long"].as<std::string_view>().data()));
+    EXPECT_TRUE(referenced(dump, std::get<1>(value["ext"].as<msgpack11::MsgPack::extension>()).data()));
+
+    // Headers and small values between the payloads are runs of scratch:
+    // at most one before each payload and one after the last.
+    EXPECT_LE(dump.iov().size(), 7u);
+
+    // A value smaller than the threshold is a single piece of scratch.
+    msgpack11::GatherDump const small(msgpack11::MsgPack::array { 1, "two", 3.0 });
+    ASSERT_EQ(small.iov().size(), 1u);
+    EXPECT_EQ(joined(small), msgpack11::MsgPack(msgpack11::MsgPack::array { 1, "two", 3.0 }).dump());
+}
+
+TEST(MSGPACK_GATHER, outlives_value)
+{
+    std::string expected;
+    msgpack11::GatherDump moved = [&] {
+        msgpack11::MsgPack const value = sample(8000);
+        expected = value.dump();
+        msgpack11::GatherDump dump(value, 64);
+        return dump;
+    }();
+    msgpack11::GatherDump const dump = std::move(moved);
+    EXPECT_EQ(joined(dump), expected);
+}
+
+TEST(MSGPACK_GATHER, borrowed_input)
+{
+    std::string const encoded = sample(8000).dump();
+    std::string err;
+    msgpack11::MsgPack const value = msgpack11::MsgPack::parse_borrowed(encoded, err);
+    ASSERT_TRUE(err.empty());
+
+    // Borrowed payloads are sent straight from the input.
+    msgpack11::GatherDump const dump(value);
+    EXPECT_TRUE(referenced(dump, value["data"].as<std::span<const uint8_t>>().data()));
+    EXPECT_EQ(msgpack11::MsgPack::parse(joined(dump), err), sample(8000));
+}
@@ -56,6 +56,6 @@ TEST(MSGPACK_OBJECT, unpack_incomplete_data)
     // msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(dumped, err) };
     // EXPECT_TRUE(parsed.is_object());
 
-    // msgpack11::MsgPack::object v2{ parsed.object_items() };
+    // msgpack11::MsgPack::object v2{ parsed.as<msgpack11::MsgPack::object>() };
     // EXPECT_TRUE(v1 == v2);
 }
@@ -38,3 +38,17 @@ TEST(MSGPACK_OBJECT, unpack_incomplete_data)
         EXPECT_GT(err.size(), 0);
     }
 }
+
+TEST(MSGPACK_OBJECT, unpack_forged_container_length)
+{
+    // array32 and map32 headers claiming 2^32-1 members, followed by two.
+    for (const char* header : { "\xdd\xff\xff\xff\xff", "\xdf\xff\xff\xff\xff" })
+    {
+        std::string corrupted{header, 5};
+        corrupted += std::string{"\x01\x02\x03\x04", 4};
+        std::string err;
+        msgpack11::MsgPack parsed{ msgpack11::MsgPack::parse(corrupted, err) };
+        EXPECT_EQ(err, "end of buffer.");
+        EXPECT_TRUE(parsed.is_null());
+    }
+}
@@ -0,0 +1,90 @@
+#include <msgpack11.hpp>
+
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// {"id": 1, "body": {"a": [1, 2], "b": "x"}} with a map16 header and a
+// uint32 that a fresh dump would encode more compactly, so that only a
+// verbatim copy reproduces it.
+std::string const body("\xde\x00\x02" "\xa1" "a" "\x92\xce\x00\x00\x00\x01\x02" "\xa1" "b" "\xa1" "x", 16);
+std::string const envelope = std::string("\x82" "\xa2" "id" "\x01" "\xa4" "body", 10) + body;
+
+}
+
+TEST(MSGPACK_LAZY, matches_parse)
+{
+    msgpack11::MsgPack const value = msgpack11::MsgPack::object {
+        { "k1", msgpack11::MsgPack::array { 1, "two", msgpack11::MsgPack::object { { "x", 3.5 } } } },
+        { "k2", msgpack11::MsgPack::binary { 1, 2 } },
+        { "k3", nullptr }
+    };
+    std::string err;
+    msgpack11::MsgPack const lazy = msgpack11::MsgPack::parse_lazy(value.dump(), err);
+    EXPECT_TRUE(err.empty());
+    EXPECT_EQ(lazy, value);
+    EXPECT_EQ(lazy["k1"][2]["x"].as<double>(), 3.5);
+
+    std::string const scalar = msgpack11::MsgPack("only").dump();
+    EXPECT_EQ(msgpack11::MsgPack::parse_lazy(scalar, err).as<std::string>(), "only");
+}
+
+TEST(MSGPACK_LAZY, untouched_bytes_are_copied)
+{
+    std::string err;
+    msgpack11::MsgPack const lazy = msgpack11::MsgPack::parse_lazy(envelope, err);
+    ASSERT_TRUE(err.empty());
+    EXPECT_EQ(lazy.dump(), envelope);
+
+    // Reading fields decodes them but keeps the original encoding.
+    EXPECT_EQ(lazy["id"].as<int>(), 1);
+    EXPECT_EQ(lazy["body"]["a"][0].as<int>(), 1);
+    EXPECT_EQ(lazy.encoded_size(), envelope.size());
+    EXPECT_EQ(lazy.dump(), envelope);
+
+    std::ostringstream os;
+    os << lazy;
+    EXPECT_EQ(os.str(), envelope);
+}
+
+TEST(MSGPACK_LAZY, mutation)
+{
+    std::string err;
+    msgpack11::MsgPack lazy = msgpack11::MsgPack::parse_lazy(envelope, err);
+    ASSERT_TRUE(err.empty());
+
+    // Changing the envelope re-encodes it, but the body is still copied.
+    lazy["id"] = 2;
+    std::string const dumped = lazy.dump();
+    EXPECT_NE(dumped.find(body), std::string::npos);
+    msgpack11::MsgPack const changed = msgpack11::MsgPack::parse(dumped, err);
+    EXPECT_EQ(changed["id"].as<int>(), 2);
+
+    // A change made through a copy of a member is seen by its parent, even
+    // though the parent itself was never handed out mutably.
+    msgpack11::MsgPack const fresh = msgpack11::MsgPack::parse_lazy(envelope, err);
+    EXPECT_EQ(fresh.dump(), envelope);
+    msgpack11::MsgPack inner = fresh["body"];
+    inner["b"] = "changed";
+    msgpack11::MsgPack const reparsed = msgpack11::MsgPack::parse(fresh.dump(), err);
+    EXPECT_TRUE(err.empty());
+    EXPECT_EQ(reparsed["body"]["b"].as<std::string>(), "changed");
+    EXPECT_EQ(reparsed["body"]["a"][1].as<int>(), 2);
+}
+
+TEST(MSGPACK_LAZY, errors)
+{
+    std::string err;
+    msgpack11::MsgPack const truncated = msgpack11::MsgPack::parse_lazy(envelope.substr(0, envelope.size() - 1), err);
+    EXPECT_EQ(err, "end of buffer.");
+    EXPECT_TRUE(truncated.is_null());
+
+    msgpack11::ParseOptions options;
+    options.max_depth = 1;
+    err.clear();
+    msgpack11::MsgPack::parse_lazy(envelope, err, options);
+    EXPECT_EQ(err, "exceeded maximum depth.");
+}
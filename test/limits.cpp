@@ -0,0 +1,99 @@
+#include <msgpack11.hpp>
+
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// n nested single-element arrays around a nil.
+std::string nested_arrays(size_t n)
+{
+    std::string encoded(n, '\x91');
+    encoded += '\xc0';
+    return encoded;
+}
+
+}
+
+TEST(MSGPACK_LIMITS, deep_nesting_within_max_depth)
+{
+    msgpack11::ParseOptions options;
+    options.max_depth = 100000;
+
+    std::string err;
+    msgpack11::MsgPack parsed = msgpack11::MsgPack::parse(nested_arrays(20000), err, options);
+    EXPECT_TRUE(err.empty());
+
+    const msgpack11::MsgPack* cur = &parsed;
+    size_t depth = 0;
+    while (cur->is_array()) {
+        cur = &(*cur)[0];
+        ++depth;
+    }
+    EXPECT_EQ(depth, 20000u);
+    EXPECT_TRUE(cur->is_null());
+}
+
+TEST(MSGPACK_LIMITS, max_depth)
+{
+    msgpack11::ParseOptions options;
+    options.max_depth = 8;
+
+    std::string err;
+    EXPECT_EQ(msgpack11::MsgPack::parse(nested_arrays(8), err, options).dump(), nested_arrays(8));
+    EXPECT_TRUE(err.empty());
+
+    msgpack11::MsgPack parsed = msgpack11::MsgPack::parse(nested_arrays(9), err, options);
+    EXPECT_EQ(err, "exceeded maximum depth.");
+    EXPECT_TRUE(parsed.is_null());
+
+    // The default still rejects hostile nesting.
+    err.clear();
+    msgpack11::MsgPack::parse(nested_arrays(100000), err);
+    EXPECT_EQ(err, "exceeded maximum depth.");
+}
+
+TEST(MSGPACK_LIMITS, max_elements)
+{
+    std::string const encoded = msgpack11::MsgPack(msgpack11::MsgPack::array{ 1, 2, msgpack11::MsgPack::object{ { "a", 3 } } }).dump();
+
+    msgpack11::ParseOptions options;
+    options.max_elements = 6;
+    std::string err;
+    msgpack11::MsgPack::parse(encoded, err, options);
+    EXPECT_TRUE(err.empty());
+
+    options.max_elements = 5;
+    msgpack11::MsgPack parsed = msgpack11::MsgPack::parse(encoded, err, options);
+    EXPECT_EQ(err, "exceeded maximum number of elements.");
+    EXPECT_TRUE(parsed.is_null());
+}
+
+TEST(MSGPACK_LIMITS, max_bytes)
+{
+    std::string const encoded = msgpack11::MsgPack(msgpack11::MsgPack::array{ std::string(100, 'x'), 1 }).dump();
+
+    msgpack11::ParseOptions options;
+    options.max_bytes = encoded.size();
+    std::string err;
+    msgpack11::MsgPack::parse(encoded, err, options);
+    EXPECT_TRUE(err.empty());
+
+    options.max_bytes = encoded.size() - 1;
+    msgpack11::MsgPack::parse(encoded, err, options);
+    EXPECT_EQ(err, "exceeded maximum size.");
+
+    // A truncated message is still reported as such.
+    err.clear();
+    msgpack11::MsgPack::parse(encoded.substr(0, encoded.size() - 1), err, options);
+    EXPECT_EQ(err, "end of buffer.");
+
+    // Streams check a forged length against the limit before allocating.
+    std::istringstream is(std::string{"\xdb\xff\xff\xff\xf0", 5});
+    err.clear();
+    msgpack11::MsgPack::parse(is, err, options);
+    EXPECT_EQ(err, "exceeded maximum size.");
+    EXPECT_TRUE(is.fail());
+}
@@ -0,0 +1,96 @@
+#include <msgpack11.hpp>
+
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+std::vector<msgpack11::MsgPack> samples()
+{
+    return {
+        msgpack11::MsgPack(1),
+        msgpack11::MsgPack::object { { "k", msgpack11::MsgPack::array { 1, "two", 3.5 } } },
+        msgpack11::MsgPack(std::string(300, 's')),
+        msgpack11::MsgPack()
+    };
+}
+
+}
+
+TEST(MSGPACK_MESSAGES, offsets_and_lengths)
+{
+    std::string encoded;
+    std::vector<size_t> offsets;
+    for (const auto &sample : samples()) {
+        offsets.push_back(encoded.size());
+        encoded += sample.dump();
+    }
+
+    msgpack11::MessageRange messages(encoded);
+    size_t i = 0;
+    for (const auto &message : messages) {
+        ASSERT_LT(i, samples().size());
+        EXPECT_EQ(message.value, samples()[i]);
+        EXPECT_EQ(message.offset, offsets[i]);
+        EXPECT_EQ(message.length, samples()[i].dump().size());
+        ++i;
+    }
+    EXPECT_EQ(i, samples().size());
+    EXPECT_TRUE(messages.error().empty());
+
+    // The range can be walked again, and its iterators are forward iterators.
+    EXPECT_EQ(std::distance(messages.begin(), messages.end()), 4);
+    auto it = messages.begin();
+    auto const first = it++;
+    EXPECT_EQ(first->offset, 0u);
+    EXPECT_EQ(it->offset, offsets[1]);
+    EXPECT_NE(first, it);
+}
+
+TEST(MSGPACK_MESSAGES, empty)
+{
+    msgpack11::MessageRange messages{std::string_view()};
+    EXPECT_EQ(messages.begin(), messages.end());
+    EXPECT_TRUE(messages.error().empty());
+}
+
+TEST(MSGPACK_MESSAGES, stops_at_a_malformed_message)
+{
+    std::string const first = msgpack11::MsgPack("first").dump();
+    std::string const second = msgpack11::MsgPack(msgpack11::MsgPack::array { 1, 2 }).dump();
+    std::string const encoded = first + second + "\x93\x01";
+
+    msgpack11::MessageRange messages(encoded);
+    std::vector<msgpack11::MsgPack> parsed;
+    for (const auto &message : messages)
+        parsed.push_back(message.value);
+    ASSERT_EQ(parsed.size(), 2u);
+    EXPECT_EQ(parsed[1], msgpack11::MsgPack(msgpack11::MsgPack::array { 1, 2 }));
+    EXPECT_EQ(messages.error(), "end of buffer.");
+    EXPECT_EQ(messages.error_offset(), first.size() + second.size());
+
+    // parse_multi() reports the same.
+    std::string err;
+    std::string::size_type stop = 0;
+    EXPECT_EQ(msgpack11::MsgPack::parse_multi(encoded, stop, err).size(), 2u);
+    EXPECT_EQ(err, "end of buffer.");
+    EXPECT_EQ(stop, first.size() + second.size());
+}
+
+TEST(MSGPACK_MESSAGES, limits_apply_per_message)
+{
+    msgpack11::ParseOptions options;
+    options.max_bytes = 16;
+    std::string const small = msgpack11::MsgPack(std::string(10, 'a')).dump();
+    std::string const large = msgpack11::MsgPack(std::string(20, 'a')).dump();
+
+    std::string const encoded = small + small + large;
+
+    msgpack11::MessageRange messages(encoded, options);
+    EXPECT_EQ(std::distance(messages.begin(), messages.end()), 2);
+    EXPECT_EQ(messages.error(), "exceeded maximum size.");
+    EXPECT_EQ(messages.error_offset(), 2 * small.size());
+}
@@ -30,17 +30,17 @@ TEST(MSGPACK_MULTI, pack_unpack_multi)
     EXPECT_EQ(multi_parsed.size(), 3);
 
     EXPECT_TRUE(multi_parsed[0].is_object());
-    msgpack11::MsgPack::object parsed_v1{ multi_parsed[0].object_items() };
+    msgpack11::MsgPack::object parsed_v1{ multi_parsed[0].as<msgpack11::MsgPack::object>() };
     EXPECT_TRUE(v1 == parsed_v1);
 
     EXPECT_TRUE(multi_parsed[1].is_object());
-    msgpack11::MsgPack::object parsed_v2{ multi_parsed[1].object_items() };
-    EXPECT_TRUE(v2["a"].int8_value() == parsed_v2["a"].int8_value());
-    EXPECT_TRUE(v2["b"].int8_value() == parsed_v2["b"].int8_value());
-    EXPECT_TRUE(v2[0x44u].object_items() == parsed_v2[0x44u].object_items());
+    msgpack11::MsgPack::object parsed_v2{ multi_parsed[1].as<msgpack11::MsgPack::object>() };
+    EXPECT_TRUE(std::as_const(v2["a"]).as<msgpack11::MsgPack::int8>() == std::as_const(parsed_v2["a"]).as<msgpack11::MsgPack::int8>());
+    EXPECT_TRUE(std::as_const(v2["b"]).as<msgpack11::MsgPack::int8>() == std::as_const(parsed_v2["b"]).as<msgpack11::MsgPack::int8>());
+    EXPECT_TRUE(v2[0x44u].as<msgpack11::MsgPack::object>() == parsed_v2[0x44u].as<msgpack11::MsgPack::object>());
 
     EXPECT_TRUE(multi_parsed[2].is_array());
-    msgpack11::MsgPack::array parsed_v3( multi_parsed[2].array_items() );
+    msgpack11::MsgPack::array parsed_v3( multi_parsed[2].as<msgpack11::MsgPack::array>() );
     EXPECT_EQ(v3.size(), parsed_v3.size());
     EXPECT_TRUE(std::equal(v3.begin(), v3.end(), parsed_v3.begin()));
 }
@@ -0,0 +1,150 @@
+#include <msgpack11.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+std::string packed(void (*pack)(msgpack11::Packer&))
+{
+    std::string out;
+    msgpack11::Packer packer(out);
+    pack(packer);
+    return out;
+}
+
+}
+
+TEST(MSGPACK_PACKER, numbers_match_dump)
+{
+    for (int64_t value : { INT64_C(0), INT64_C(1), INT64_C(127), INT64_C(128), INT64_C(255), INT64_C(256),
+                           INT64_C(65535), INT64_C(65536), INT64_C(4294967295), INT64_C(4294967296),
+                           INT64_C(-1), INT64_C(-32), INT64_C(-33), INT64_C(-128), INT64_C(-129),
+                           INT64_C(-32768), INT64_C(-32769), INT64_C(-2147483648), INT64_C(-2147483649),
+                           std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max() }) {
+        std::string out;
+        msgpack11::Packer(out).pack_int(value);
+        EXPECT_EQ(out, msgpack11::MsgPack(value).dump()) << value;
+    }
+
+    std::string out;
+    msgpack11::Packer packer(out);
+    packer.pack_uint(std::numeric_limits<uint64_t>::max()).pack_double(0.5).pack_float(1.5f).pack_bool(true).pack_nil();
+    EXPECT_EQ(out, msgpack11::MsgPack(std::numeric_limits<uint64_t>::max()).dump() + msgpack11::MsgPack(0.5).dump() +
+                   msgpack11::MsgPack(1.5f).dump() + msgpack11::MsgPack(true).dump() + msgpack11::MsgPack().dump());
+
+    // pack() picks by type.
+    std::string typed;
+    msgpack11::Packer(typed).pack(static_cast<uint8_t>(200)).pack(-5).pack(false).pack(1.5f).pack(2.5);
+    EXPECT_EQ(typed, std::string("\xcc\xc8\xfb\xc2\xca\x3f\xc0\x00\x00\xcb\x40\x04\x00\x00\x00\x00\x00\x00", 18));
+}
+
+TEST(MSGPACK_PACKER, lengths_match_dump)
+{
+    for (size_t size : { 0, 1, 2, 4, 8, 16, 31, 32, 255, 256, 65535, 65536 }) {
+        std::string const text(size, 'a');
+        msgpack11::MsgPack::binary const bytes(size, 0x5a);
+
+        std::string out;
+        msgpack11::Packer(out).pack_str(text).pack_bin(bytes).pack_ext(3, bytes);
+        EXPECT_EQ(out, msgpack11::MsgPack(text).dump() + msgpack11::MsgPack(bytes).dump() +
+                       msgpack11::MsgPack(msgpack11::MsgPack::extension { 3, bytes }).dump()) << size;
+    }
+
+    for (uint32_t size : { 0u, 15u, 16u, 65535u, 65536u }) {
+        std::string out;
+        msgpack11::Packer packer(out);
+        packer.begin_array(size);
+        for (uint32_t i = 0; i < size; ++i)
+            packer.pack_nil();
+        EXPECT_EQ(out, msgpack11::MsgPack(msgpack11::MsgPack::array(size)).dump()) << size;
+    }
+}
+
+TEST(MSGPACK_PACKER, containers)
+{
+    std::string const out = packed([](msgpack11::Packer& packer) {
+        packer.begin_map(2);
+        packer.pack_str("id").pack(7);
+        packer.pack_str("items").begin_array(3);
+        packer.pack_str("a").pack(msgpack11::MsgPack::array { 1, 2 }).begin_map(0);
+    });
+
+    std::string err;
+    EXPECT_EQ(msgpack11::MsgPack::parse(out, err), (msgpack11::MsgPack::object {
+                                                       { "id", 7 },
+                                                       { "items", msgpack11::MsgPack::array {
+                                                                      "a",
+                                                                      msgpack11::MsgPack::array { 1, 2 },
+                                                                      msgpack11::MsgPack::object {}
+                                                                  } }
+                                                   }));
+    EXPECT_TRUE(err.empty());
+}
+
+TEST(MSGPACK_PACKER, appends_to_binary)
+{
+    msgpack11::MsgPack::binary out { 0xc0 };
+    msgpack11::Packer(out).begin_array(1).pack_str("x");
+    EXPECT_EQ(out, (msgpack11::MsgPack::binary { 0xc0, 0x91, 0xa1, 'x' }));
+}
+
+TEST(MSGPACK_PACKER, unsized_containers)
+{
+    msgpack11::MsgPack const expected = msgpack11::MsgPack::array {
+        msgpack11::MsgPack::object { { "row", 0 }, { "cells", msgpack11::MsgPack::array { 1, 2 } } },
+        msgpack11::MsgPack::object { { "row", 1 }, { "cells", msgpack11::MsgPack::array {} } },
+        msgpack11::MsgPack::array(20, "x")
+    };
+
+    for (bool compact : { false, true }) {
+        std::string out;
+        msgpack11::Packer packer(out);
+        packer.begin_array();
+        for (int row = 0; row < 2; ++row) {
+            packer.begin_map();
+            packer.pack_str("row").pack(row);
+            packer.pack_str("cells");
+            if (row == 0)
+                packer.begin_array(2).pack(1).pack(2);
+            else
+                packer.begin_array().end_array(compact);
+            packer.end_map(compact);
+        }
+        packer.begin_array();
+        for (int i = 0; i < 20; ++i)
+            packer.pack_str("x");
+        packer.end_array(compact).end_array(compact);
+
+        std::string err;
+        EXPECT_EQ(msgpack11::MsgPack::parse(out, err), expected) << compact;
+        EXPECT_TRUE(err.empty());
+        EXPECT_EQ(out[0], compact ? '\x93' : '\xdd');
+        if (compact) {
+            EXPECT_EQ(out.size(), expected.encoded_size());
+        }
+    }
+}
+
+TEST(MSGPACK_PACKER, unsized_errors)
+{
+    std::string out;
+    msgpack11::Packer packer(out);
+    EXPECT_THROW(packer.end_array(), std::runtime_error);
+
+    packer.begin_map();
+    EXPECT_THROW(packer.end_array(), std::runtime_error);
+    packer.pack_str("key");
+    EXPECT_THROW(packer.end_map(), std::runtime_error);
+    packer.pack_nil().end_map(true);
+    EXPECT_EQ(out, std::string("\x81\xa3key\xc0", 6));
+
+    // A counted container still open inside is not the one to close.
+    msgpack11::Packer nested(out);
+    nested.begin_array().begin_array(2).pack(1);
+    EXPECT_THROW(nested.end_array(), std::runtime_error);
+}
@@ -0,0 +1,143 @@
+#include <msgpack11.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// Allocations of exactly this many bytes fail, so that a test can make one
+// value's decode throw wherever it runs. Kept out of line, where GCC cannot
+// pair a library new with the free() below and warn.
+static std::atomic<size_t> failing_size { 0 };
+
+[[gnu::noinline]] void *operator new(std::size_t size)
+{
+    if (size != 0 && size == failing_size.load(std::memory_order_relaxed))
+        throw std::bad_alloc();
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void *p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+msgpack11::MsgPack::array elements(size_t count)
+{
+    msgpack11::MsgPack::array values;
+    for (size_t i = 0; i < count; ++i) {
+        switch (i % 4) {
+        case 0: values.push_back(static_cast<int>(i)); break;
+        case 1: values.push_back("element-" + std::to_string(i)); break;
+        case 2: values.push_back(msgpack11::MsgPack::object { { "i", static_cast<uint32_t>(i) }, { "b", msgpack11::MsgPack::binary(i % 50, 1) } }); break;
+        default: values.push_back(msgpack11::MsgPack::array { 1.5, nullptr, msgpack11::MsgPack::array { true } }); break;
+        }
+    }
+    return values;
+}
+
+}
+
+TEST(MSGPACK_PARALLEL, array_matches_parse)
+{
+    for (size_t count : { 0, 1, 3, 1000 }) {
+        std::string const encoded = msgpack11::MsgPack(elements(count)).dump();
+        for (unsigned threads : { 1u, 2u, 3u, 8u, 0u }) {
+            std::string err;
+            msgpack11::MsgPack const parsed = msgpack11::MsgPack::parse_parallel(encoded, err, {}, threads);
+            EXPECT_TRUE(err.empty());
+            EXPECT_EQ(parsed, msgpack11::MsgPack(elements(count)));
+        }
+    }
+
+    // Anything else is parsed as usual.
+    std::string err;
+    EXPECT_EQ(msgpack11::MsgPack::parse_parallel(msgpack11::MsgPack("scalar").dump(), err, {}, 4), msgpack11::MsgPack("scalar"));
+}
+
+TEST(MSGPACK_PARALLEL, array_errors_match_parse)
+{
+    std::string const encoded = msgpack11::MsgPack(elements(100)).dump();
+
+    std::vector<std::pair<std::string, msgpack11::ParseOptions>> cases;
+    cases.emplace_back(encoded.substr(0, encoded.size() - 1), msgpack11::ParseOptions());
+    cases.emplace_back(encoded.substr(0, 3) + "\xc1" + encoded.substr(4), msgpack11::ParseOptions());
+    msgpack11::ParseOptions depth;
+    depth.max_depth = 2;
+    cases.emplace_back(encoded, depth);
+    msgpack11::ParseOptions elements;
+    elements.max_elements = 200;
+    cases.emplace_back(encoded, elements);
+    msgpack11::ParseOptions bytes;
+    bytes.max_bytes = encoded.size() - 1;
+    cases.emplace_back(encoded, bytes);
+
+    for (const auto &[input, options] : cases) {
+        std::string expected_err;
+        msgpack11::MsgPack const expected = msgpack11::MsgPack::parse(input, expected_err, options);
+        std::string err;
+        msgpack11::MsgPack const parsed = msgpack11::MsgPack::parse_parallel(input, err, options, 4);
+        EXPECT_FALSE(expected_err.empty());
+        EXPECT_EQ(err, expected_err);
+        EXPECT_EQ(parsed, expected);
+    }
+}
+
+TEST(MSGPACK_PARALLEL, messages_match_parse_multi)
+{
+    std::string encoded;
+    for (const auto &element : elements(500))
+        encoded += element.dump();
+
+    for (const std::string &input : { encoded, encoded + "\x92\x01", encoded.substr(0, 700) + "\xc1" + encoded.substr(701), std::string() }) {
+        std::string expected_err;
+        std::string::size_type expected_stop = 0;
+        std::vector<msgpack11::MsgPack> const expected = msgpack11::MsgPack::parse_multi(input, expected_stop, expected_err);
+
+        for (unsigned threads : { 1u, 4u }) {
+            std::string err;
+            std::string::size_type stop = 0;
+            std::vector<msgpack11::MsgPack> const parsed = msgpack11::MsgPack::parse_multi_parallel(input, stop, err, {}, threads);
+            EXPECT_EQ(parsed, expected);
+            EXPECT_EQ(stop, expected_stop);
+            EXPECT_EQ(err, expected_err);
+        }
+    }
+
+    // A limit broken by a message in the middle stops there.
+    msgpack11::ParseOptions depth;
+    depth.max_depth = 1;
+    std::string err;
+    std::string::size_type stop = 0;
+    std::vector<msgpack11::MsgPack> const parsed = msgpack11::MsgPack::parse_multi_parallel(encoded, stop, err, depth, 4);
+    EXPECT_EQ(parsed.size(), 3u);
+    EXPECT_EQ(err, "exceeded maximum depth.");
+}
+
+TEST(MSGPACK_PARALLEL, exceptions_reach_the_caller)
+{
+    // Strings of the same length, bar the last, which a worker decodes.
+    msgpack11::MsgPack::array values(40, std::string(1000, 's'));
+    values.push_back(std::string(1500, 'l'));
+    std::string const encoded = msgpack11::MsgPack(values).dump();
+    std::string messages;
+    for (const auto &value : values)
+        messages += value.dump();
+
+    // Its bytes plus the terminator.
+    failing_size = 1501;
+    std::string err;
+    std::string::size_type stop = 0;
+    EXPECT_THROW(msgpack11::MsgPack::parse(encoded, err), std::bad_alloc);
+    EXPECT_THROW(msgpack11::MsgPack::parse_parallel(encoded, err, {}, 4), std::bad_alloc);
+    EXPECT_THROW(msgpack11::MsgPack::parse_multi_parallel(messages, stop, err, {}, 4), std::bad_alloc);
+    failing_size = 0;
+
+    EXPECT_EQ(msgpack11::MsgPack::parse_parallel(encoded, err, {}, 4), msgpack11::MsgPack(values));
+    EXPECT_TRUE(err.empty());
+}
@@ -0,0 +1,62 @@
+#include <msgpack11.hpp>
+
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "sample.hpp"
+
+TEST(MSGPACK_PATH, compile)
+{
+    std::string err;
+    EXPECT_EQ(msgpack11::Path("", err).size(), 0u);
+    EXPECT_EQ(msgpack11::Path("a.b[3].c", err).size(), 4u);
+    EXPECT_EQ(msgpack11::Path("[0][1]", err).size(), 2u);
+    EXPECT_EQ(msgpack11::Path("a[\"b.c\"]", err).size(), 2u);
+    EXPECT_TRUE(err.empty());
+
+    for (const char* bad : { ".a", "a.", "a..b", "a[", "a[]", "a[x]", "a[1", "a[1]b", "a[\"b]" }) {
+        err.clear();
+        EXPECT_EQ(msgpack11::Path(bad, err).size(), 0u) << bad;
+        EXPECT_EQ(err, "invalid path.") << bad;
+    }
+}
+
+TEST(MSGPACK_PATH, extract)
+{
+    std::string const encoded = sample().dump();
+    std::string err;
+
+    EXPECT_EQ(msgpack11::extract(encoded, msgpack11::Path("id", err)).as<int>(), 70000);
+    EXPECT_EQ(msgpack11::extract(encoded, msgpack11::Path("user.name", err)).as<std::string_view>(), "ada");
+    EXPECT_EQ(msgpack11::extract(encoded, msgpack11::Path("user.tags[1].k", err)).as<double>(), 1.5);
+    EXPECT_EQ(msgpack11::extract(encoded, msgpack11::Path("user[\"a.b\"]", err)).as<std::string_view>(), "dotted");
+    EXPECT_EQ(msgpack11::extract(encoded, msgpack11::Path("counters[99]", err)).as<int>(), 99);
+    EXPECT_EQ(msgpack11::extract(encoded, msgpack11::Path("user.tags", err)).to_msgpack(), sample()["user"]["tags"]);
+    EXPECT_EQ(msgpack11::extract(encoded, msgpack11::Path("", err)).to_msgpack(), sample());
+    EXPECT_TRUE(err.empty());
+
+    // The result points into the encoded bytes.
+    std::string_view const name = msgpack11::extract(encoded, msgpack11::Path("user.name", err)).as<std::string_view>();
+    EXPECT_GE(name.data(), encoded.data());
+    EXPECT_LT(name.data(), encoded.data() + encoded.size());
+}
+
+TEST(MSGPACK_PATH, missing_and_mismatched)
+{
+    std::string const encoded = sample().dump();
+    std::string err;
+
+    // Missing keys and indices, and steps past a nil, read as nil.
+    EXPECT_TRUE(msgpack11::extract(encoded, msgpack11::Path("nope", err)).is_null());
+    EXPECT_TRUE(msgpack11::extract(encoded, msgpack11::Path("counters[100]", err)).is_null());
+    EXPECT_TRUE(msgpack11::extract(encoded, msgpack11::Path("user.none.deeper[2]", err)).is_null());
+
+    EXPECT_THROW(msgpack11::extract(encoded, msgpack11::Path("id.x", err)), std::runtime_error);
+    EXPECT_THROW(msgpack11::extract(encoded, msgpack11::Path("user[0]", err)), std::runtime_error);
+
+    // Looking for a missing key walks every entry, so it finds the truncation.
+    std::string const truncated = encoded.substr(0, encoded.size() - 1);
+    EXPECT_THROW(msgpack11::extract(truncated, msgpack11::Path("nope", err)), std::runtime_error);
+}
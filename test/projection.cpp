@@ -0,0 +1,119 @@
+#include <msgpack11.hpp>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+msgpack11::MsgPack record(int id)
+{
+    msgpack11::MsgPack::object fields {
+        { "id", id },
+        { "user", msgpack11::MsgPack::object {
+                      { "name", "ada" },
+                      { "email", "ada@example.com" },
+                      { "roles", msgpack11::MsgPack::array { "admin", "dev" } }
+                  } },
+        { "payload", msgpack11::MsgPack::binary(256, 7) },
+        { 5, "integer key" }
+    };
+    for (int i = 0; i < 20; ++i)
+        fields["field" + std::to_string(i)] = msgpack11::MsgPack::array { i, std::to_string(i) };
+    return fields;
+}
+
+}
+
+TEST(MSGPACK_PROJECTION, flat)
+{
+    std::string err;
+    msgpack11::MsgPack const parsed = msgpack11::MsgPack::parse(record(1).dump(), err, { .keep_keys = { "id", "field3", "missing" } });
+    EXPECT_TRUE(err.empty());
+    EXPECT_EQ(parsed, (msgpack11::MsgPack::object {
+                          { "id", 1 },
+                          { "field3", msgpack11::MsgPack::array { 3, "3" } }
+                      }));
+}
+
+TEST(MSGPACK_PROJECTION, nested)
+{
+    std::string err;
+    msgpack11::ParseOptions options;
+    options.keep_keys.add("user.name");
+    options.keep_keys.add("user.roles");
+    options.keep_keys.add("id");
+    msgpack11::MsgPack const parsed = msgpack11::MsgPack::parse(record(2).dump(), err, options);
+    EXPECT_TRUE(err.empty());
+    EXPECT_EQ(parsed, (msgpack11::MsgPack::object {
+                          { "id", 2 },
+                          { "user", msgpack11::MsgPack::object {
+                                        { "name", "ada" },
+                                        { "roles", msgpack11::MsgPack::array { "admin", "dev" } }
+                                    } }
+                      }));
+
+    // A shorter path keeps the whole value, whichever comes first.
+    options.keep_keys.add("user");
+    EXPECT_EQ(msgpack11::MsgPack::parse(record(2).dump(), err, options)["user"], record(2)["user"]);
+
+    // A path into a value that is not a map keeps the value as it is.
+    msgpack11::MsgPack const id = msgpack11::MsgPack::parse(record(2).dump(), err, { .keep_keys = { "id.x" } });
+    EXPECT_EQ(id, (msgpack11::MsgPack::object { { "id", 2 } }));
+}
+
+TEST(MSGPACK_PROJECTION, arrays_of_records)
+{
+    msgpack11::MsgPack const records = msgpack11::MsgPack::array { record(1), record(2), 3 };
+    std::string err;
+    msgpack11::ParseOptions const options { .keep_keys = { "id" } };
+    msgpack11::MsgPack::array const expected {
+        msgpack11::MsgPack::object { { "id", 1 } },
+        msgpack11::MsgPack::object { { "id", 2 } },
+        3
+    };
+    EXPECT_EQ(msgpack11::MsgPack::parse(records.dump(), err, options), msgpack11::MsgPack(expected));
+    EXPECT_EQ(msgpack11::MsgPack::parse_parallel(records.dump(), err, options, 2), msgpack11::MsgPack(expected));
+    EXPECT_TRUE(err.empty());
+
+    std::string const stream = record(1).dump() + record(2).dump();
+    msgpack11::MessageRange messages(stream, options);
+    int ids = 0;
+    for (const auto& message : messages) {
+        EXPECT_EQ(message.value.as<msgpack11::MsgPack::object>().size(), 1u);
+        ids += message.value["id"].as<int>();
+    }
+    EXPECT_EQ(ids, 3);
+}
+
+TEST(MSGPACK_PROJECTION, stream_parser)
+{
+    std::string const encoded = record(4).dump();
+    msgpack11::ParseOptions const options { .keep_keys = { "user.email", "field19" } };
+    std::string err;
+    msgpack11::MsgPack const expected = msgpack11::MsgPack::parse(encoded, err, options);
+    ASSERT_EQ(expected.as<msgpack11::MsgPack::object>().size(), 2u);
+
+    for (size_t split = 0; split <= encoded.size(); ++split) {
+        msgpack11::MsgPackStreamParser parser(options);
+        auto status = parser.feed(encoded.data(), split);
+        if (split < encoded.size())
+            status = parser.feed(encoded.data() + split, encoded.size() - split);
+        ASSERT_EQ(status, msgpack11::MsgPackStreamParser::Status::COMPLETE);
+        EXPECT_EQ(parser.get(), expected);
+    }
+}
+
+TEST(MSGPACK_PROJECTION, limits_cover_skipped_values)
+{
+    std::string const encoded = record(1).dump();
+    std::string err;
+    msgpack11::ParseOptions options { .keep_keys = { "id" } };
+    options.max_elements = 20;
+    msgpack11::MsgPack::parse(encoded, err, options);
+    EXPECT_EQ(err, "exceeded maximum number of elements.");
+
+    err.clear();
+    msgpack11::MsgPack::parse(encoded.substr(0, encoded.size() - 1), err, { .keep_keys = { "id" } });
+    EXPECT_EQ(err, "end of buffer.");
+}
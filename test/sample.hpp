@@ -0,0 +1,42 @@
+#pragma once
+
+#include <msgpack11.hpp>
+
+#include <cstdint>
+#include <string>
+
+// A message with every type in it: short strings and binaries next to
+// ones large bytes long, maps nested in arrays and arrays in maps, a nil,
+// a key with a dot in it and an integer key.
+inline msgpack11::MsgPack sample(size_t large = 300)
+{
+    using msgpack11::MsgPack;
+    MsgPack::array counters;
+    for (int i = 0; i < 100; ++i)
+        counters.push_back(i);
+    return MsgPack::object {
+        { "id", static_cast<uint32_t>(70000) },
+        { "name", "router" },
+        { "ratio", 0.25 },
+        { "flag", false },
+        { "delta", -5 },
+        { "long", std::string(large, 'x') },
+        { "blob", MsgPack::binary { 1, 2, 3 } },
+        { "data", MsgPack::binary(large, 0xab) },
+        { "ext", MsgPack::extension { 3, MsgPack::binary(large, 1) } },
+        { "items", MsgPack::array {
+                       MsgPack::object { { "k", 1 } },
+                       "two",
+                       MsgPack::array { 3, 4 },
+                       nullptr
+                   } },
+        { "user", MsgPack::object {
+                      { "name", "ada" },
+                      { "tags", MsgPack::array { "x", MsgPack::object { { "k", 1.5 } }, MsgPack::binary { 1, 2 } } },
+                      { "a.b", "dotted" },
+                      { "none", nullptr }
+                  } },
+        { "counters", counters },
+        { 7, "integer key" }
+    };
+}
@@ -0,0 +1,94 @@
+#include <msgpack11.hpp>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sample.hpp"
+
+TEST(MSGPACK_STREAM, every_split)
+{
+    msgpack11::MsgPack const expected = sample();
+    std::string const encoded = expected.dump();
+
+    for (size_t split = 0; split <= encoded.size(); ++split) {
+        msgpack11::MsgPackStreamParser parser;
+        auto status = parser.feed(encoded.data(), split);
+        if (split < encoded.size()) {
+            ASSERT_EQ(status, msgpack11::MsgPackStreamParser::Status::NEED_MORE);
+            EXPECT_EQ(parser.consumed(), split);
+            status = parser.feed(encoded.data() + split, encoded.size() - split);
+        }
+        ASSERT_EQ(status, msgpack11::MsgPackStreamParser::Status::COMPLETE);
+        EXPECT_EQ(parser.get(), expected);
+    }
+}
+
+TEST(MSGPACK_STREAM, byte_at_a_time)
+{
+    msgpack11::MsgPack const expected = sample();
+    std::string const encoded = expected.dump();
+
+    msgpack11::MsgPackStreamParser parser;
+    for (size_t i = 0; i + 1 < encoded.size(); ++i)
+        ASSERT_EQ(parser.feed(&encoded[i], 1), msgpack11::MsgPackStreamParser::Status::NEED_MORE);
+    ASSERT_EQ(parser.feed(&encoded.back(), 1), msgpack11::MsgPackStreamParser::Status::COMPLETE);
+    EXPECT_EQ(parser.get(), expected);
+}
+
+TEST(MSGPACK_STREAM, messages_back_to_back)
+{
+    std::string const encoded = msgpack11::MsgPack(1).dump() + sample().dump() + msgpack11::MsgPack("last").dump();
+
+    msgpack11::MsgPackStreamParser parser;
+    std::vector<msgpack11::MsgPack> parsed;
+    size_t offset = 0;
+    while (offset < encoded.size()) {
+        auto const status = parser.feed(encoded.data() + offset, encoded.size() - offset);
+        ASSERT_EQ(status, msgpack11::MsgPackStreamParser::Status::COMPLETE);
+        offset += parser.consumed();
+        parsed.push_back(parser.get());
+    }
+
+    ASSERT_EQ(parsed.size(), 3u);
+    EXPECT_EQ(parsed[0], msgpack11::MsgPack(1));
+    EXPECT_EQ(parsed[1], sample());
+    EXPECT_EQ(parsed[2], msgpack11::MsgPack("last"));
+}
+
+TEST(MSGPACK_STREAM, format_error)
+{
+    std::string const encoded = "\x92\x01\xc1";
+
+    msgpack11::MsgPackStreamParser parser;
+    EXPECT_EQ(parser.feed(encoded.data(), 2), msgpack11::MsgPackStreamParser::Status::NEED_MORE);
+    EXPECT_EQ(parser.feed(encoded.data() + 2, 1), msgpack11::MsgPackStreamParser::Status::FAILED);
+    EXPECT_EQ(parser.error(), "format error.");
+    EXPECT_EQ(parser.feed("\x01", 1), msgpack11::MsgPackStreamParser::Status::FAILED);
+}
+
+TEST(MSGPACK_STREAM, max_bytes)
+{
+    msgpack11::ParseOptions options;
+    options.max_bytes = 64;
+
+    // A str32 header claiming 4GiB fails as soon as its length is known.
+    msgpack11::MsgPackStreamParser parser(options);
+    EXPECT_EQ(parser.feed("\xdb\xff\xff", 3), msgpack11::MsgPackStreamParser::Status::NEED_MORE);
+    EXPECT_EQ(parser.feed("\xff\xff", 2), msgpack11::MsgPackStreamParser::Status::FAILED);
+    EXPECT_EQ(parser.error(), "exceeded maximum size.");
+
+    // The budget is per message.
+    std::string const small = msgpack11::MsgPack(std::string(40, 'a')).dump();
+    msgpack11::MsgPackStreamParser repeated(options);
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(repeated.feed(small.data(), small.size()), msgpack11::MsgPackStreamParser::Status::COMPLETE);
+        EXPECT_EQ(repeated.get().as<std::string>(), std::string(40, 'a'));
+    }
+
+    std::string const large = msgpack11::MsgPack(std::string(100, 'a')).dump();
+    msgpack11::MsgPackStreamParser too_large(options);
+    EXPECT_EQ(too_large.feed(large.data(), large.size()), msgpack11::MsgPackStreamParser::Status::FAILED);
+    EXPECT_EQ(too_large.error(), "exceeded maximum size.");
+}
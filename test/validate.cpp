@@ -0,0 +1,131 @@
+#include <msgpack11.hpp>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "sample.hpp"
+
+TEST(MSGPACK_VALIDATE, well_formed)
+{
+    std::string const encoded = sample().dump();
+    std::string err;
+    EXPECT_EQ(msgpack11::MsgPack::validate(encoded, err), encoded.size());
+    EXPECT_TRUE(err.empty());
+
+    // Anything after the value fails the check, at the end of the value.
+    std::string const trailing = encoded + "\xc1";
+    EXPECT_EQ(msgpack11::MsgPack::validate(trailing, err), encoded.size());
+    EXPECT_EQ(err, "trailing data.");
+}
+
+TEST(MSGPACK_VALIDATE, several_values)
+{
+    std::string const first = msgpack11::MsgPack(1).dump();
+    std::string const second = sample().dump();
+    std::string const third = msgpack11::MsgPack("last").dump();
+    std::string const encoded = first + second + third;
+
+    std::string err;
+    EXPECT_EQ(msgpack11::MsgPack::validate(encoded, err, {}, 2), first.size() + second.size());
+    EXPECT_EQ(err, "trailing data.");
+
+    err.clear();
+    EXPECT_EQ(msgpack11::MsgPack::validate(encoded, err, {}, 3), encoded.size());
+    EXPECT_EQ(msgpack11::MsgPack::validate(encoded, err, {}, 0), encoded.size());
+    EXPECT_TRUE(err.empty());
+
+    EXPECT_EQ(msgpack11::MsgPack::validate(encoded, err, {}, 4), encoded.size());
+    EXPECT_EQ(err, "end of buffer.");
+
+    err.clear();
+    EXPECT_EQ(msgpack11::MsgPack::validate(std::string_view(), err, {}, 0), 0u);
+    EXPECT_TRUE(err.empty());
+}
+
+TEST(MSGPACK_VALIDATE, fixint_runs)
+{
+    // Runs of positive and negative fixints cross every 8-byte boundary and
+    // are broken up by other tokens at different offsets.
+    for (size_t length = 0; length < 40; ++length) {
+        msgpack11::MsgPack::array values;
+        for (size_t i = 0; i < length; ++i) {
+            if (i % 11 == 10)
+                values.push_back(static_cast<uint16_t>(1000));
+            else if (i % 7 == 6)
+                values.push_back("s");
+            else
+                values.push_back(static_cast<int>(i % 2 ? -static_cast<int>(i) % 32 : i));
+        }
+        std::string const encoded = msgpack11::MsgPack(values).dump() + msgpack11::MsgPack(values).dump();
+        std::string err;
+        EXPECT_EQ(msgpack11::MsgPack::validate(encoded, err, {}, 0), encoded.size());
+        EXPECT_TRUE(err.empty());
+
+        // A fixint run never reaches past the end of its array.
+        std::string const cut = encoded.substr(0, encoded.size() - 1);
+        // Empty arrays are one byte each, so cutting one leaves nothing behind.
+        EXPECT_EQ(msgpack11::MsgPack::validate(cut, err), encoded.size() / 2);
+        EXPECT_EQ(err, length ? "trailing data." : "");
+        err.clear();
+        EXPECT_GE(msgpack11::MsgPack::validate(cut, err, {}, 2), encoded.size() / 2);
+        EXPECT_EQ(err, "end of buffer.");
+        err.clear();
+    }
+}
+
+TEST(MSGPACK_VALIDATE, error_positions)
+{
+    std::string err;
+    // [1, 2, <0xc1>, 3] fails at the reserved byte.
+    EXPECT_EQ(msgpack11::MsgPack::validate(std::string("\x94\x01\x02\xc1\x03", 5), err), 3u);
+    EXPECT_EQ(err, "format error.");
+
+    // {"ab": "cdef"} cut off inside "cdef" fails at the string.
+    err.clear();
+    EXPECT_EQ(msgpack11::MsgPack::validate(std::string("\x81\xa2" "ab" "\xa4" "cd", 7), err), 4u);
+    EXPECT_EQ(err, "end of buffer.");
+
+    // A bin8 header without its length.
+    err.clear();
+    EXPECT_EQ(msgpack11::MsgPack::validate(std::string("\x91\xc4", 2), err), 1u);
+    EXPECT_EQ(err, "end of buffer.");
+
+    err.clear();
+    EXPECT_EQ(msgpack11::MsgPack::validate(std::string_view(), err), 0u);
+    EXPECT_EQ(err, "end of buffer.");
+}
+
+TEST(MSGPACK_VALIDATE, limits)
+{
+    std::string const encoded = sample().dump();
+    std::string err;
+
+    msgpack11::ParseOptions depth;
+    depth.max_depth = 4;
+    EXPECT_EQ(msgpack11::MsgPack::validate(encoded, err, depth), encoded.size());
+    EXPECT_TRUE(err.empty());
+    depth.max_depth = 3;
+    EXPECT_LT(msgpack11::MsgPack::validate(encoded, err, depth), encoded.size());
+    EXPECT_EQ(err, "exceeded maximum depth.");
+
+    msgpack11::ParseOptions elements;
+    elements.max_elements = 6;
+    err.clear();
+    EXPECT_EQ(msgpack11::MsgPack::validate(std::string("\x95\x01\x02\x03\x04\x05", 6), err, elements), 6u);
+    EXPECT_TRUE(err.empty());
+    EXPECT_EQ(msgpack11::MsgPack::validate(std::string("\x96\x01\x02\x03\x04\x05\x06\x07\x08\x09", 10), err, elements), 6u);
+    EXPECT_EQ(err, "exceeded maximum number of elements.");
+
+    msgpack11::ParseOptions bytes;
+    bytes.max_bytes = 64;
+    err.clear();
+    EXPECT_LT(msgpack11::MsgPack::validate(encoded, err, bytes), 64u);
+    EXPECT_EQ(err, "exceeded maximum size.");
+
+    // The limits apply to each value separately.
+    std::string const small = msgpack11::MsgPack(std::string(40, 'a')).dump();
+    err.clear();
+    EXPECT_EQ(msgpack11::MsgPack::validate(small + small + small, err, bytes, 0), 3 * small.size());
+    EXPECT_TRUE(err.empty());
+}
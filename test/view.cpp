@@ -0,0 +1,104 @@
+#include <msgpack11.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sample.hpp"
+
+TEST(MSGPACK_VIEW, scalars)
+{
+    std::string const encoded = sample().dump();
+    msgpack11::MsgPackView const view(encoded);
+
+    EXPECT_TRUE(view.is_object());
+    EXPECT_EQ(view.size(), 13u);
+    EXPECT_EQ(view["id"].type(), msgpack11::MsgPack::Type::UINT32);
+    EXPECT_EQ(view["id"].as<uint32_t>(), 70000u);
+    EXPECT_EQ(view["id"].as<double>(), 70000.0);
+    EXPECT_EQ(view["name"].as<std::string_view>(), "router");
+    EXPECT_EQ(view["ratio"].as<double>(), 0.25);
+
+    std::span<const uint8_t> const blob = view["blob"].as<std::span<const uint8_t>>();
+    EXPECT_EQ(std::vector<uint8_t>(blob.begin(), blob.end()), (std::vector<uint8_t> { 1, 2, 3 }));
+
+    // The string view points into the encoded bytes.
+    std::string_view const name = view["name"].as<std::string_view>();
+    EXPECT_GE(name.data(), encoded.data());
+    EXPECT_LT(name.data(), encoded.data() + encoded.size());
+}
+
+TEST(MSGPACK_VIEW, navigation)
+{
+    std::string const encoded = sample().dump();
+    msgpack11::MsgPackView const view(encoded);
+
+    msgpack11::MsgPackView const items = view["items"];
+    ASSERT_TRUE(items.is_array());
+    EXPECT_EQ(items.size(), 4u);
+    EXPECT_EQ(items[0]["k"].as<int>(), 1);
+    EXPECT_EQ(items[1].as<std::string_view>(), "two");
+    EXPECT_EQ(items[2][1].as<int>(), 4);
+    EXPECT_TRUE(items[3].is_null());
+
+    // Missing keys and elements read as nil, as with MsgPack.
+    EXPECT_TRUE(view["missing"].is_null());
+    EXPECT_TRUE(items[4].is_null());
+    EXPECT_TRUE(msgpack11::MsgPackView().is_null());
+
+    EXPECT_EQ(msgpack11::MsgPack(items), sample()["items"]);
+    EXPECT_EQ(msgpack11::MsgPack(view), sample());
+}
+
+TEST(MSGPACK_VIEW, iteration)
+{
+    msgpack11::MsgPack const value = sample();
+    std::string const encoded = value.dump();
+    msgpack11::MsgPackView const view(encoded);
+
+    std::vector<int> numbers;
+    for (msgpack11::MsgPackView item : view["items"][2])
+        numbers.push_back(item.as<int>());
+    EXPECT_EQ(numbers, (std::vector<int> { 3, 4 }));
+
+    size_t entries = 0;
+    for (auto it = view.begin(); it != view.end(); ++it) {
+        msgpack11::MsgPack const key = *it;
+        EXPECT_EQ(msgpack11::MsgPack(it.value()), value[key]);
+        ++entries;
+    }
+    EXPECT_EQ(entries, 13u);
+}
+
+TEST(MSGPACK_VIEW, bytes)
+{
+    std::string const encoded = sample().dump();
+    msgpack11::MsgPackView const view(encoded);
+
+    std::span<const uint8_t> const whole = view.bytes();
+    EXPECT_EQ(whole.size(), encoded.size());
+
+    std::span<const uint8_t> const items = view["items"].bytes();
+    EXPECT_EQ(std::string(items.begin(), items.end()), sample()["items"].dump());
+}
+
+TEST(MSGPACK_VIEW, errors)
+{
+    std::string const encoded = sample().dump();
+    msgpack11::MsgPackView const view(encoded);
+
+    EXPECT_THROW(view["name"].as<int>(), std::runtime_error);
+    EXPECT_THROW(view["id"].as<std::string_view>(), std::runtime_error);
+    EXPECT_THROW(view[0], std::runtime_error);
+    EXPECT_THROW(view["items"]["k"], std::runtime_error);
+
+    // Truncation only surfaces once a lookup reaches the missing bytes:
+    // {"id": 1, "name": "abc"} cut off inside "abc".
+    std::string const truncated("\x82\xa2id\x01\xa4name\xa3" "ab", 13);
+    msgpack11::MsgPackView const partial(truncated);
+    EXPECT_EQ(partial["id"].as<int>(), 1);
+    EXPECT_THROW(partial["name"].as<std::string_view>(), std::runtime_error);
+    EXPECT_THROW(partial["missing"], std::runtime_error);
+}
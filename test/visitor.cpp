@@ -0,0 +1,104 @@
+#include <msgpack11.hpp>
+
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// Writes each event as a token, so that tests can compare event sequences.
+class Trace : public msgpack11::MsgPackVisitor
+{
+public:
+    std::ostringstream events;
+
+    void on_nil() override                { events << "nil "; }
+    void on_bool(bool value) override     { events << (value ? "true " : "false "); }
+    void on_int(int64_t value) override   { events << 'i' << value << ' '; }
+    void on_uint(uint64_t value) override { events << 'u' << value << ' '; }
+    void on_float(double value) override  { events << 'f' << value << ' '; }
+    void on_str(std::string_view value) override { events << '\'' << value << "' "; }
+    void on_bin(std::span<const uint8_t> value) override { events << "bin" << value.size() << ' '; }
+    void on_ext(uint8_t type, std::span<const uint8_t> value) override
+    {
+        events << "ext" << int(type) << ':' << value.size() << ' ';
+    }
+    void begin_array(uint32_t size) override { events << '[' << size << ' '; }
+    void end_array() override                { events << "] "; }
+    void begin_map(uint32_t size) override   { events << '{' << size << ' '; }
+    void end_map() override                  { events << "} "; }
+};
+
+// Only looks at integers.
+class Sum : public msgpack11::MsgPackVisitor
+{
+public:
+    int64_t total = 0;
+
+    void on_int(int64_t value) override   { total += value; }
+    void on_uint(uint64_t value) override { total += static_cast<int64_t>(value); }
+};
+
+}
+
+TEST(MSGPACK_VISITOR, events)
+{
+    msgpack11::MsgPack::array const values {
+        nullptr,
+        true,
+        static_cast<uint8_t>(7),
+        static_cast<int8_t>(-3),
+        static_cast<uint32_t>(70000),
+        static_cast<int64_t>(-5000000000),
+        1.5,
+        "abc",
+        msgpack11::MsgPack::binary { 1, 2, 3 },
+        msgpack11::MsgPack::extension { 9, { 1, 2, 3, 4 } },
+        msgpack11::MsgPack::array {},
+        msgpack11::MsgPack::object { { "k", msgpack11::MsgPack::array { false } } }
+    };
+    std::string const encoded = msgpack11::MsgPack(values).dump();
+
+    Trace trace;
+    std::string err;
+    msgpack11::MsgPack::visit(encoded, trace, err);
+    EXPECT_TRUE(err.empty());
+    EXPECT_EQ(trace.events.str(),
+              "[12 nil true u7 i-3 u70000 i-5000000000 f1.5 'abc' bin3 ext9:4 "
+              "[0 ] {1 'k' [1 false ] } ] ");
+}
+
+TEST(MSGPACK_VISITOR, unhandled_events_are_ignored)
+{
+    msgpack11::MsgPack const value = msgpack11::MsgPack::object {
+        { "a", 1 },
+        { "b", msgpack11::MsgPack::array { 2, "skip", -3 } },
+        { "c", msgpack11::MsgPack::object { { "d", static_cast<uint64_t>(40) } } }
+    };
+
+    Sum sum;
+    std::string err;
+    msgpack11::MsgPack::visit(value.dump(), sum, err);
+    EXPECT_TRUE(err.empty());
+    EXPECT_EQ(sum.total, 40);
+}
+
+TEST(MSGPACK_VISITOR, errors)
+{
+    Trace trace;
+    std::string err;
+    msgpack11::MsgPack::visit(std::string("\x92\x01\xc1", 3), trace, err);
+    EXPECT_EQ(err, "format error.");
+    EXPECT_EQ(trace.events.str(), "[2 u1 ");
+
+    err.clear();
+    msgpack11::MsgPack::visit(std::string("\xa5" "ab", 3), trace, err);
+    EXPECT_EQ(err, "end of buffer.");
+
+    msgpack11::ParseOptions options;
+    options.max_depth = 1;
+    err.clear();
+    msgpack11::MsgPack::visit(std::string("\x91\x91\xc0", 3), trace, err, options);
+    EXPECT_EQ(err, "exceeded maximum depth.");
+}